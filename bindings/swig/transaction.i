@@ -89,9 +89,15 @@ typedef libdnf::CompsPackageType CompsPackageType;
 %template() std::pair<int,std::string>;
 %template() std::map<std::string,int>;
 %template() std::map<std::string,std::string>;
+%template() std::map<std::string,std::vector<std::string> >;
 %template() std::vector<std::pair<int,std::string> >;
 
 
+// items grouped by transaction ID are used internally by MergedTransaction
+%ignore libdnf::RPMItem::getTransactionItemsInRange;
+%ignore libdnf::CompsGroupItem::getTransactionItemsInRange;
+%ignore libdnf::CompsEnvironmentItem::getTransactionItemsInRange;
+
 // make SWIG look into following headers
 %include "libdnf/transaction/Item.hpp"
 %include "libdnf/transaction/CompsEnvironmentItem.hpp"
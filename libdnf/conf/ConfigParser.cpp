@@ -26,9 +26,19 @@
 
 namespace libdnf {
 
-void ConfigParser::substitute(std::string & text,
-    const std::map<std::string, std::string> & substitutions)
+ConfigParser::SubstitutionTemplate::SubstitutionTemplate(const std::string & text)
+  : raw(text)
 {
+    auto addLiteral = [this, &text](std::string::size_type from, std::string::size_type to) {
+        if (from >= to)
+            return;
+        if (!segments.empty() && !segments.back().isVariable)
+            segments.back().text.append(text, from, to - from);
+        else
+            segments.push_back({text.substr(from, to - from), "", false});
+    };
+
+    std::string::size_type literal = 0;
     auto start = text.find_first_of("$");
     while (start != text.npos)
     {
@@ -46,21 +56,65 @@ void ConfigParser::substitute(std::string & text,
             [](char c){return std::isalnum(c) || c=='_';});
         if (bracket && it == text.end())
             break;
-        auto pastVariable = std::distance(text.begin(), it);
+        std::string::size_type pastVariable = std::distance(text.begin(), it);
         if (bracket && *it != '}') {
             start = text.find_first_of("$", pastVariable);
             continue;
         }
-        auto subst = substitutions.find(text.substr(variable, pastVariable - variable));
-        if (subst != substitutions.end()) {
-            if (bracket)
-                ++pastVariable;
-            text.replace(start, pastVariable - start, subst->second);
-            start = text.find_first_of("$", start + subst->second.length());
-        } else {
-            start = text.find_first_of("$", pastVariable);
+        auto pastReference = bracket ? pastVariable + 1 : pastVariable;
+        addLiteral(literal, start);
+        segments.push_back({text.substr(start, pastReference - start),
+                            text.substr(variable, pastVariable - variable), true});
+        hasVariables = true;
+        literal = pastReference;
+        start = text.find_first_of("$", pastVariable);
+    }
+    addLiteral(literal, text.length());
+}
+
+std::string ConfigParser::SubstitutionTemplate::substitute(
+    const std::map<std::string, std::string> & substitutions) const
+{
+    if (!hasVariables)
+        return raw;
+
+    std::vector<const std::string *> parts;
+    parts.reserve(segments.size());
+    std::string::size_type length = 0;
+    for (const auto & segment : segments) {
+        const std::string * part = &segment.text;
+        if (segment.isVariable) {
+            auto subst = substitutions.find(segment.variable);
+            if (subst != substitutions.end())
+                part = &subst->second;
         }
+        parts.push_back(part);
+        length += part->length();
     }
+
+    std::string result;
+    result.reserve(length);
+    for (auto part : parts)
+        result += *part;
+    return result;
+}
+
+void ConfigParser::substitute(std::string & text,
+    const std::map<std::string, std::string> & substitutions)
+{
+    SubstitutionTemplate compiled(text);
+    if (compiled.hasVariables)
+        text = compiled.substitute(substitutions);
+}
+
+void ConfigParser::compileValue(const std::string & section, const std::string & key, const std::string & value)
+{
+    auto cacheKey = section + ']' + key;
+    auto compiled = substitutionTemplates.find(cacheKey);
+    if (compiled == substitutionTemplates.end())
+        substitutionTemplates.emplace(std::move(cacheKey), SubstitutionTemplate(value));
+    else
+        compiled->second = SubstitutionTemplate(value);
 }
 
 static void read(ConfigParser & cfgParser, IniParser & parser)
@@ -147,9 +201,12 @@ ConfigParser::getValue(const std::string & section, const std::string & key) con
 std::string
 ConfigParser::getSubstitutedValue(const std::string & section, const std::string & key) const
 {
-    auto ret = getValue(section, key);
-    substitute(ret, substitutions);
-    return ret;
+    const auto & value = getValue(section, key);
+    auto compiled = substitutionTemplates.find(section + ']' + key);
+    if (compiled != substitutionTemplates.end() && compiled->second.raw == value)
+        return compiled->second.substitute(substitutions);
+    // the value was modified through getData()
+    return SubstitutionTemplate(value).substitute(substitutions);
 }
 
 static void writeKeyVals(std::ostream & out, const std::string & section, const ConfigParser::Container::mapped_type & keyValMap, const std::map<std::string, std::string> & rawItems)
@@ -32,6 +32,7 @@
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace libdnf {
 
@@ -135,6 +136,15 @@ public:
     void addCommentLine(const std::string & section, const std::string & comment);
     void addCommentLine(const std::string & section, std::string && comment);
     const std::string & getValue(const std::string & section, const std::string & key) const;
+    /**
+    * @brief Returns the value of the option with the substitutions applied
+    *
+    * Values are compiled by setValue(), the method only reads the parser state. A value modified
+    * through getData() is compiled again on every call.
+    *
+    * @param section Name of the section
+    * @param key Name of the option
+    */
     std::string getSubstitutedValue(const std::string & section, const std::string & key) const;
     const std::string & getHeader() const noexcept;
     std::string & getHeader() noexcept;
@@ -142,11 +152,37 @@ public:
     Container & getData() noexcept;
 
 private:
+    /**
+    * @brief Text split into literal parts and variable references
+    *
+    * Compiling the text once allows to substitute it repeatedly without rescanning it.
+    */
+    struct SubstitutionTemplate {
+        struct Segment {
+            // literal text, or the original reference kept when the variable is not substituted
+            std::string text;
+            // name of the referenced variable
+            std::string variable;
+            bool isVariable;
+        };
+
+        explicit SubstitutionTemplate(const std::string & text);
+        std::string substitute(const std::map<std::string, std::string> & substitutions) const;
+
+        std::string raw;
+        std::vector<Segment> segments;
+        bool hasVariables{false};
+    };
+
+    void compileValue(const std::string & section, const std::string & key, const std::string & value);
+
     std::map<std::string, std::string> substitutions;
     Container data;
     int itemNumber{0};
     std::string header;
     std::map<std::string, std::string> rawItems;
+    // compiled values by section ']' key, kept in sync by setValue() and remove methods
+    std::map<std::string, SubstitutionTemplate> substitutionTemplates;
 };
 
 inline void ConfigParser::setSubstitutions(const std::map<std::string, std::string> & substitutions)
@@ -214,6 +250,7 @@ inline void ConfigParser::setValue(const std::string & section, const std::strin
         rawItems.erase(section + ']' + key);
     else
         rawItems[section + ']' + key] = rawItem;
+    compileValue(section, key, value);
     sectionIter->second[key] = value;
 }
 
@@ -226,14 +263,20 @@ inline void ConfigParser::setValue(const std::string & section, std::string && k
         rawItems.erase(section + ']' + key);
     else
         rawItems[section + ']' + key] = std::move(rawItem);
+    compileValue(section, key, value);
     sectionIter->second[std::move(key)] = std::move(value);
 }
 
 inline bool ConfigParser::removeSection(const std::string & section)
 {
     auto removed = data.erase(section) > 0;
-    if (removed)
+    if (removed) {
         rawItems.erase(section);
+        auto prefix = section + ']';
+        auto compiled = substitutionTemplates.lower_bound(prefix);
+        while (compiled != substitutionTemplates.end() && compiled->first.compare(0, prefix.size(), prefix) == 0)
+            compiled = substitutionTemplates.erase(compiled);
+    }
     return removed;
 }
 
@@ -243,8 +286,10 @@ inline bool ConfigParser::removeOption(const std::string & section, const std::s
     if (sectionIter == data.end())
         return false;
     auto removed = sectionIter->second.erase(key) > 0;
-    if (removed)
+    if (removed) {
         rawItems.erase(section + ']' + key);
+        substitutionTemplates.erase(section + ']' + key);
+    }
     return removed;
 }
 
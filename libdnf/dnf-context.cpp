@@ -1864,6 +1864,53 @@ dnf_context_setup_sack_with_flags(DnfContext               *context,
     return TRUE;
 } CATCH_TO_GERROR(FALSE)
 
+/**
+ * dnf_context_reload_system_repo:
+ * @context: a #DnfContext instance.
+ * @error: A #GError or %NULL
+ *
+ * Reloads only the installed packages into the sack, e.g. after the "invalidate" signal
+ * caused by a changed rpmdb. Available repos stay loaded, which is much cheaper than setting
+ * up the whole sack again. The goal is created again as it refers to the previous installed
+ * packages. If the sack was not set up yet, or if it cannot be reloaded without growing its
+ * pool, it is set up.
+ *
+ * Returns: %TRUE for success, %FALSE otherwise
+ *
+ * Since: 0.70.2
+ **/
+gboolean
+dnf_context_reload_system_repo(DnfContext *context, GError **error) try
+{
+    DnfContextPrivate *priv = GET_PRIVATE(context);
+
+    if (priv->sack == nullptr)
+        return dnf_context_setup_sack(context, priv->state, error);
+    g_autoptr(GError) error_local = nullptr;
+    if (!dnf_sack_reload_system_repo(priv->sack, &error_local)) {
+        if (!g_error_matches(error_local, DNF_ERROR, DNF_ERROR_NO_CAPABILITY)) {
+            g_propagate_error(error, static_cast<GError *>(g_steal_pointer(&error_local)));
+            return FALSE;
+        }
+
+        /* the pool would grow with every reload, start over with a new sack */
+        g_debug("%s, setting up the sack again", error_local->message);
+        if (priv->goal != nullptr) {
+            hy_goal_free(priv->goal);
+            priv->goal = nullptr;
+        }
+        g_object_unref(priv->sack);
+        priv->sack = nullptr;
+        return dnf_context_setup_sack(context, priv->state, error);
+    }
+
+    /* create goal */
+    if (priv->goal != nullptr)
+        hy_goal_free(priv->goal);
+    priv->goal = hy_goal_create(priv->sack);
+    return TRUE;
+} CATCH_TO_GERROR(FALSE)
+
 /**
  * dnf_context_ensure_exists:
  **/
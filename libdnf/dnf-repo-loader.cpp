@@ -32,16 +32,46 @@
  */
 
 #include <strings.h>
+#include <sys/stat.h>
 
 #include <gio/gunixmounts.h>
 #include <librepo/util.h>
 #include <string.h>
 
+#include <map>
+#include <memory>
+#include <string>
+
 #include "catch-error.hpp"
+#include "dnf-context.hpp"
 #include "dnf-package.h"
-#include "dnf-repo-loader.h"
+#include "dnf-repo-loader-private.hpp"
+#include "dnf-repo.hpp"
 #include "dnf-utils.h"
 
+/* Repos parsed from one config file, reused as long as the file is unchanged */
+struct DnfRepoLoaderSnapshot
+{
+    DnfRepoLoaderSnapshot() : repos(g_ptr_array_new_with_free_func((GDestroyNotify) g_object_unref)) {}
+    ~DnfRepoLoaderSnapshot()
+    {
+        g_ptr_array_unref(repos);
+        if (keyfile)
+            g_key_file_unref(keyfile);
+    }
+    DnfRepoLoaderSnapshot(const DnfRepoLoaderSnapshot &) = delete;
+    DnfRepoLoaderSnapshot & operator=(const DnfRepoLoaderSnapshot &) = delete;
+
+    dev_t            dev{0};
+    ino_t            ino{0};
+    off_t            size{0};
+    gint64           mtime_ns{0};
+    GKeyFile        *keyfile{nullptr};
+    GPtrArray       *repos;
+};
+
+typedef std::map<std::string, std::unique_ptr<DnfRepoLoaderSnapshot>> DnfRepoLoaderSnapshots;
+
 typedef struct
 {
     GPtrArray       *monitor_repos;
@@ -49,6 +79,8 @@ typedef struct
     GPtrArray       *repos;
     GVolumeMonitor  *volume_monitor;
     gboolean         loaded;
+    DnfRepoLoaderSnapshots *snapshots;
+    std::string     *snapshots_env;
 } DnfRepoLoaderPrivate;
 
 enum {
@@ -64,7 +96,7 @@ G_DEFINE_TYPE_WITH_PRIVATE(DnfRepoLoader, dnf_repo_loader, G_TYPE_OBJECT)
 /**
  * dnf_repo_loader_invalidate:
  */
-static void
+void
 dnf_repo_loader_invalidate(DnfRepoLoader *self)
 {
     DnfRepoLoaderPrivate *priv = GET_PRIVATE(self);
@@ -121,6 +153,8 @@ dnf_repo_loader_finalize(GObject *object)
     g_signal_handlers_disconnect_by_func(priv->volume_monitor, (gpointer) dnf_repo_loader_mount_changed_cb, self);
     g_object_unref(priv->volume_monitor);
     g_ptr_array_unref(priv->repos);
+    delete priv->snapshots;
+    delete priv->snapshots_env;
 
     G_OBJECT_CLASS(dnf_repo_loader_parent_class)->finalize(object);
 }
@@ -134,6 +168,8 @@ dnf_repo_loader_init(DnfRepoLoader *self)
     DnfRepoLoaderPrivate *priv = GET_PRIVATE(self);
     priv->monitor_repos = g_ptr_array_new_with_free_func((GDestroyNotify) g_object_unref);
     priv->repos = g_ptr_array_new_with_free_func((GDestroyNotify) g_object_unref);
+    priv->snapshots = new DnfRepoLoaderSnapshots;
+    priv->snapshots_env = new std::string;
     priv->volume_monitor = g_volume_monitor_get();
     g_signal_connect(priv->volume_monitor, "mount-added",
                      G_CALLBACK(dnf_repo_loader_mount_changed_cb), self);
@@ -357,6 +393,7 @@ dnf_repo_loader_repo_parse_id(DnfRepoLoader *self,
                               const gchar *id,
                               const gchar *filename,
                               GKeyFile *keyfile,
+                              GPtrArray *repos,
                               GError **error)
 {
     DnfRepoLoaderPrivate *priv = GET_PRIVATE(self);
@@ -373,29 +410,23 @@ dnf_repo_loader_repo_parse_id(DnfRepoLoader *self,
         return FALSE;
 
     g_debug("added repo %s\t%s", filename, id);
-    g_ptr_array_add(priv->repos, g_object_ref(repo));
+    g_ptr_array_add(repos, g_object_ref(repo));
     return TRUE;
 }
 
 /**
- * dnf_repo_loader_repo_parse:
+ * dnf_repo_loader_repo_parse_keyfile:
  **/
 static gboolean
-dnf_repo_loader_repo_parse(DnfRepoLoader *self,
-                           const gchar *filename,
-                           GError **error)
+dnf_repo_loader_repo_parse_keyfile(DnfRepoLoader *self,
+                                   const gchar *filename,
+                                   GKeyFile *keyfile,
+                                   GPtrArray *repos,
+                                   GError **error)
 {
     gboolean ret = TRUE;
     guint i;
     g_auto(GStrv) groups = NULL;
-    g_autoptr(GKeyFile) keyfile = NULL;
-
-    /* load non-standard keyfile */
-    keyfile = dnf_repo_loader_load_multiline_key_file(filename, error);
-    if (keyfile == NULL) {
-        g_prefix_error(error, "Failed to load %s: ", filename);
-        return FALSE;
-    }
 
     /* save all the repos listed in the file, "main" section is skipped - repoid can't be "main" */
     groups = g_key_file_get_groups(keyfile, NULL);
@@ -403,13 +434,134 @@ dnf_repo_loader_repo_parse(DnfRepoLoader *self,
         if (strcmp(groups[i], "main") == 0) {
             continue;
         }
-        ret = dnf_repo_loader_repo_parse_id(self, groups[i], filename, keyfile, error);
+        ret = dnf_repo_loader_repo_parse_id(self, groups[i], filename, keyfile, repos, error);
         if (!ret)
             return FALSE;
     }
     return TRUE;
 }
 
+/**
+ * dnf_repo_loader_repo_parse:
+ **/
+static gboolean
+dnf_repo_loader_repo_parse(DnfRepoLoader *self,
+                           const gchar *filename,
+                           DnfRepoLoaderSnapshot *snapshot,
+                           GError **error)
+{
+    /* load non-standard keyfile */
+    snapshot->keyfile = dnf_repo_loader_load_multiline_key_file(filename, error);
+    if (snapshot->keyfile == NULL) {
+        g_prefix_error(error, "Failed to load %s: ", filename);
+        return FALSE;
+    }
+    return dnf_repo_loader_repo_parse_keyfile(self, filename, snapshot->keyfile, snapshot->repos, error);
+}
+
+/**
+ * dnf_repo_loader_get_snapshots_env:
+ *
+ * Everything apart from the file contents that the parsed repos depend on.
+ */
+static std::string
+dnf_repo_loader_get_snapshots_env(DnfRepoLoader *self, const gchar *cfg_file_path)
+{
+    DnfRepoLoaderPrivate *priv = GET_PRIVATE(self);
+    std::string env;
+
+    for (auto value : {dnf_context_get_release_ver(priv->context),
+                       dnf_context_get_base_arch(priv->context),
+                       dnf_context_get_cache_dir(priv->context),
+                       dnf_context_get_user_agent(priv->context),
+                       dnf_context_get_http_proxy(priv->context)}) {
+        env += value != NULL ? value : "";
+        env += '\n';
+    }
+    /* the librepo cache dir is set only with zchunk */
+    env += dnf_context_get_zchunk(priv->context) ? "zchunk\n" : "\n";
+
+    /* repos inherit their defaults from the main configuration */
+    struct stat st;
+    if (cfg_file_path[0] != '\0' && stat(cfg_file_path, &st) == 0) {
+        env += std::to_string(st.st_dev) + ':' + std::to_string(st.st_ino) + ':' +
+               std::to_string(st.st_size) + ':' + std::to_string(st.st_mtim.tv_sec) + '.' +
+               std::to_string(st.st_mtim.tv_nsec) + '\n';
+    }
+
+    libdnf::dnf_context_load_vars(priv->context);
+    for (const auto & item : libdnf::dnf_context_get_vars(priv->context))
+        env += item.first + '=' + item.second + '\n';
+    return env;
+}
+
+/**
+ * dnf_repo_loader_repo_parse_cached:
+ *
+ * Adds the repos defined in @filename, parsing the file only if it changed
+ * since the previous refresh.
+ */
+static gboolean
+dnf_repo_loader_repo_parse_cached(DnfRepoLoader *self,
+                                  const gchar *filename,
+                                  DnfRepoLoaderSnapshots &old_snapshots,
+                                  DnfRepoLoaderSnapshots &snapshots,
+                                  GError **error)
+{
+    DnfRepoLoaderPrivate *priv = GET_PRIVATE(self);
+    std::unique_ptr<DnfRepoLoaderSnapshot> snapshot;
+    struct stat st;
+    gboolean have_stat = stat(filename, &st) == 0;
+    gint64 mtime_ns = 0;
+
+    if (have_stat) {
+        mtime_ns = st.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) + st.st_mtim.tv_nsec;
+        auto it = old_snapshots.find(filename);
+        if (it != old_snapshots.end() &&
+            it->second->dev == st.st_dev &&
+            it->second->ino == st.st_ino &&
+            it->second->size == st.st_size &&
+            it->second->mtime_ns == mtime_ns) {
+            g_debug("reusing repos from unchanged %s", filename);
+            snapshot = std::move(it->second);
+            old_snapshots.erase(it);
+        }
+    }
+
+    /* repos changed at runtime are set up again from the parsed file, as new repos would be */
+    if (snapshot) {
+        for (guint i = 0; i < snapshot->repos->len; i++) {
+            auto repo = static_cast<DnfRepo *>(g_ptr_array_index(snapshot->repos, i));
+            if (libdnf::dnf_repo_is_modified(repo)) {
+                g_debug("setting up modified repos from %s again", filename);
+                g_ptr_array_set_size(snapshot->repos, 0);
+                if (!dnf_repo_loader_repo_parse_keyfile(self, filename, snapshot->keyfile,
+                                                        snapshot->repos, error))
+                    return FALSE;
+                break;
+            }
+        }
+    }
+
+    if (!snapshot) {
+        snapshot.reset(new DnfRepoLoaderSnapshot);
+        if (!dnf_repo_loader_repo_parse(self, filename, snapshot.get(), error))
+            return FALSE;
+        if (have_stat) {
+            snapshot->dev = st.st_dev;
+            snapshot->ino = st.st_ino;
+            snapshot->size = st.st_size;
+            snapshot->mtime_ns = mtime_ns;
+        }
+    }
+
+    for (guint i = 0; i < snapshot->repos->len; i++)
+        g_ptr_array_add(priv->repos, g_object_ref(g_ptr_array_index(snapshot->repos, i)));
+    if (have_stat)
+        snapshots[filename] = std::move(snapshot);
+    return TRUE;
+}
+
 /**
  * dnf_repo_loader_refresh:
  */
@@ -417,6 +569,7 @@ static gboolean
 dnf_repo_loader_refresh(DnfRepoLoader *self, GError **error)
 {
     DnfRepoLoaderPrivate *priv = GET_PRIVATE(self);
+    DnfRepoLoaderSnapshots snapshots;
 
     if (!dnf_context_plugin_hook(priv->context, PLUGIN_HOOK_ID_CONTEXT_PRE_REPOS_RELOAD, nullptr, nullptr))
         return FALSE;
@@ -429,11 +582,18 @@ dnf_repo_loader_refresh(DnfRepoLoader *self, GError **error)
     if (!dnf_context_setup_enrollments(priv->context, error))
         return FALSE;
 
-    /* load repos defined in main configuration */
+    /* repos parsed by the previous refresh are only valid in the same environment */
     auto cfg_file_path = dnf_context_get_config_file_path();
+    auto env = dnf_repo_loader_get_snapshots_env(self, cfg_file_path);
+    if (env != *priv->snapshots_env) {
+        priv->snapshots->clear();
+        *priv->snapshots_env = env;
+    }
+
+    /* load repos defined in main configuration */
     if (cfg_file_path[0] != '\0' &&
         (dnf_context_is_set_config_file_path() || g_file_test(cfg_file_path, G_FILE_TEST_IS_REGULAR))) {
-        if (!dnf_repo_loader_repo_parse(self, cfg_file_path, error)) {
+        if (!dnf_repo_loader_repo_parse_cached(self, cfg_file_path, *priv->snapshots, snapshots, error)) {
             return FALSE;
         }
     }
@@ -453,11 +613,14 @@ dnf_repo_loader_refresh(DnfRepoLoader *self, GError **error)
             if (!g_str_has_suffix(file, ".repo"))
                 continue;
             path_tmp = g_build_filename(repo_path, file, NULL);
-            if (!dnf_repo_loader_repo_parse(self, path_tmp, error))
+            if (!dnf_repo_loader_repo_parse_cached(self, path_tmp, *priv->snapshots, snapshots, error))
                 return FALSE;
         }
     }
 
+    /* snapshots of removed files are dropped */
+    priv->snapshots->swap(snapshots);
+
     /* add any DVD repos */
     if (!dnf_repo_loader_get_repos_removable(self, error))
         return FALSE;
@@ -493,6 +656,12 @@ dnf_repo_loader_has_removable_repos(DnfRepoLoader *self)
 /**
  * dnf_repo_loader_get_repos:
  *
+ * Repos defined in config files which did not change since the previous load
+ * are the same objects as before. Repos changed by a dnf_repo_set_*() call are
+ * set up again from their config file and return to their configured state.
+ * Changes done directly to the configuration of the #HyRepo from
+ * dnf_repo_get_repo() are not detected and stay in reused repos.
+ *
  * Returns:(transfer container)(element-type DnfRepo): Array of repos
  */
 GPtrArray *
@@ -84,6 +84,7 @@ typedef struct
     LrResult        *repo_result;
     LrUrlVars       *urlvars;
     bool            unit_test_mode;  /* ugly hack for unit tests */
+    bool            modified;        /* changed by a setter after dnf_repo_setup() */
 } DnfRepoPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(DnfRepo, dnf_repo, G_TYPE_OBJECT)
@@ -550,6 +551,7 @@ void
 dnf_repo_set_id(DnfRepo *repo, const gchar *id)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     libdnf::repoGetImpl(priv->repo)->id = id;
     libdnf::repoGetImpl(priv->repo)->conf->name().set(libdnf::Option::Priority::RUNTIME, id);
 }
@@ -567,6 +569,7 @@ void
 dnf_repo_set_location(DnfRepo *repo, const gchar *location)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     g_free(priv->location);
     g_free(priv->packages);
     g_free(priv->keyring);
@@ -609,6 +612,7 @@ void
 dnf_repo_set_filename(DnfRepo *repo, const gchar *filename)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
 
     g_free(priv->filename);
     priv->filename = g_strdup(filename);
@@ -627,6 +631,7 @@ void
 dnf_repo_set_packages(DnfRepo *repo, const gchar *packages)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     g_free(priv->packages);
     priv->packages = g_strdup(packages);
 }
@@ -661,6 +666,7 @@ void
 dnf_repo_set_enabled(DnfRepo *repo, DnfRepoEnabled enabled)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
 
     priv->enabled = enabled;
 
@@ -683,6 +689,7 @@ void
 dnf_repo_set_required(DnfRepo *repo, gboolean required)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     priv->repo->getConfig()->skip_if_unavailable().set(libdnf::Option::Priority::RUNTIME, !required);
 }
 
@@ -699,6 +706,7 @@ void
 dnf_repo_set_cost(DnfRepo *repo, guint cost)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     repoGetImpl(priv->repo)->conf->cost().set(libdnf::Option::Priority::RUNTIME, cost);
 }
 
@@ -715,6 +723,7 @@ void
 dnf_repo_set_module_hotfixes(DnfRepo *repo, gboolean module_hotfixes)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     priv->repo->getConfig()->module_hotfixes().set(libdnf::Option::Priority::RUNTIME, module_hotfixes);
 }
 
@@ -731,6 +740,7 @@ void
 dnf_repo_set_kind(DnfRepo *repo, DnfRepoKind kind)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     priv->kind = kind;
 }
 
@@ -747,6 +757,7 @@ void
 dnf_repo_set_gpgcheck(DnfRepo *repo, gboolean gpgcheck_pkgs)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     priv->repo->getConfig()->gpgcheck().set(libdnf::Option::Priority::RUNTIME, gpgcheck_pkgs);
 }
 
@@ -763,6 +774,7 @@ void
 dnf_repo_set_skip_if_unavailable(DnfRepo *repo, gboolean skip_if_unavailable)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     priv->repo->getConfig()->skip_if_unavailable().set(libdnf::Option::Priority::RUNTIME, skip_if_unavailable);
 }
 
@@ -779,6 +791,7 @@ void
 dnf_repo_set_gpgcheck_md(DnfRepo *repo, gboolean gpgcheck_md)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     priv->repo->getConfig()->repo_gpgcheck().set(libdnf::Option::Priority::RUNTIME, gpgcheck_md);
 }
 
@@ -795,6 +808,7 @@ void
 dnf_repo_set_keyfile(DnfRepo *repo, GKeyFile *keyfile)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     if (priv->keyfile != NULL)
         g_key_file_unref(priv->keyfile);
     priv->keyfile = g_key_file_ref(keyfile);
@@ -811,6 +825,7 @@ void
 dnf_repo_set_metadata_expire(DnfRepo *repo, guint metadata_expire)
 {
     DnfRepoPrivate *priv = GET_PRIVATE(repo);
+    priv->modified = true;
     priv->repo->getConfig()->metadata_expire().set(libdnf::Option::Priority::RUNTIME, metadata_expire);
 }
 
@@ -1296,7 +1311,10 @@ dnf_repo_setup(DnfRepo *repo, GError **error) try
 
     dnf_repo_set_enabled(repo, enabled);
 
-    return dnf_repo_set_keyfile_data(repo, FALSE, error);
+    if (!dnf_repo_set_keyfile_data(repo, FALSE, error))
+        return FALSE;
+    priv->modified = false;
+    return TRUE;
 } CATCH_TO_GERROR(FALSE)
 
 typedef struct
@@ -2409,3 +2427,13 @@ dnf_repo_get_metadata_content(DnfRepo * repo, const gchar * metadataType, gpoint
         return FALSE;
     }
 } CATCH_TO_GERROR(FALSE)
+
+namespace libdnf {
+
+bool
+dnf_repo_is_modified(DnfRepo * repo)
+{
+    return GET_PRIVATE(repo)->modified;
+}
+
+}
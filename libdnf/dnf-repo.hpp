@@ -33,5 +33,11 @@ inline DnfRepoEnabled & operator|=(DnfRepoEnabled & a, DnfRepoEnabled b)
     return a = a | b;
 }
 
+namespace libdnf {
+
+/* Tells whether a setter changed the repo after dnf_repo_setup() */
+bool dnf_repo_is_modified(DnfRepo * repo);
+
+}
 
 #endif /* __DNF_REPO_HPP */
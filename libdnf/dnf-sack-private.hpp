@@ -22,6 +22,7 @@
 #define HY_SACK_INTERNAL_H
 
 #include <stdio.h>
+#include <solv/evr.h>
 #include <solv/pool.h>
 #include <vector>
 
@@ -62,10 +63,86 @@ libdnf::PackageSet *dnf_sack_get_pkg_solvables(DnfSack *sack);
 libdnf::ModulePackageContainer * dnf_sack_set_module_container(
     DnfSack *sack, libdnf::ModulePackageContainer * newConteiner);
 libdnf::ModulePackageContainer * dnf_sack_get_module_container(DnfSack *sack);
+
+/**
+ * @brief Returns true when an active module matches name, stream and context. Answers are
+ *        cached per sack until the module container or its set of active modules changes.
+ *
+ * @param sack p_sack:...
+ * @param name Module name Id
+ * @param stream Module stream Id
+ * @param context Module context Id
+ * @return bool
+ */
+bool         dnf_sack_is_module_applicable  (DnfSack *sack, Id name, Id stream, Id context);
 void         dnf_sack_make_provides_ready   (DnfSack    *sack);
+
+/**
+ * @brief Push into candidates all packages whose dependencies of rcoKey (SOLVABLE_REQUIRES,
+ *        SOLVABLE_RECOMMENDS, ...) can match dep. The result is a superset of really matching
+ *        packages and it can contain duplicates. It is backed by a lazily built reverse index
+ *        that is dropped whenever provides are recomputed.
+ *
+ * @param sack p_sack:...
+ * @param rcoKey Solvable key of the dependency array
+ * @param dep Reldep or name Id to be matched
+ * @param candidates Queue to push candidate package Ids into
+ */
+void         dnf_sack_get_rco_candidates    (DnfSack *sack, Id rcoKey, Id dep, Queue *candidates);
+
+/**
+ * @brief Returns installed packages with given name (and arch when non zero) sorted by EVR and
+ *        for equal EVRs by Id. It is backed by a lazily built index that is dropped whenever
+ *        provides are recomputed.
+ *
+ * @param sack p_sack:...
+ * @param name Name Id
+ * @param arch Arch Id or 0 for any arch
+ * @return const std::vector<Id>* or nullptr when no such package is installed
+ */
+const std::vector<Id> * dnf_sack_get_installed_by_name(DnfSack *sack, Id name, Id arch);
+
+/**
+ * @brief Returns table of ranks indexed by evr Id. The rank is an ordinal of EVR of solvables
+ *        in rpm version ordering, EVRs comparing equal have equal ranks and 0 means unknown
+ *        EVR. The table is rebuilt when new solvables appear in the pool.
+ *
+ * @param sack p_sack:...
+ * @return const std::vector<int>&
+ */
+const std::vector<int> & dnf_sack_get_evr_ranks(DnfSack *sack);
+
+/**
+ * @brief Compare two EVR Ids like pool_evrcmp() with EVRCMP_COMPARE, using the rank table from
+ *        dnf_sack_get_evr_ranks() and falling back to pool_evrcmp() for unknown EVRs.
+ */
+static inline int
+dnf_sack_evr_rank_cmp(Pool *pool, const std::vector<int> & ranks, Id evr1, Id evr2)
+{
+    if (evr1 == evr2)
+        return 0;
+    if (static_cast<size_t>(evr1) < ranks.size() && static_cast<size_t>(evr2) < ranks.size()) {
+        int rank1 = ranks[evr1];
+        int rank2 = ranks[evr2];
+        if (rank1 && rank2)
+            return (rank1 > rank2) - (rank1 < rank2);
+    }
+    return pool_evrcmp(pool, evr1, evr2, EVRCMP_COMPARE);
+}
 Id           dnf_sack_running_kernel        (DnfSack    *sack);
 void         dnf_sack_recompute_considered_map  (DnfSack * sack, Map ** considered, libdnf::Query::ExcludeFlags flags);
 void         dnf_sack_recompute_considered  (DnfSack    *sack);
+
+/**
+ * @brief Returns considered map for given exclude flags or nullptr when all packages are
+ *        considered. The maps are owned by the sack, kept up to date incrementally for
+ *        APPLY_EXCLUDES and recomputed for other flags only after excludes or includes change.
+ *
+ * @param sack p_sack:...
+ * @param flags Which excludes to ignore
+ * @return const Map* valid until excludes or includes of the sack change
+ */
+const Map *  dnf_sack_get_considered_map    (DnfSack *sack, libdnf::Query::ExcludeFlags flags);
 Id           dnf_sack_last_solvable         (DnfSack    *sack);
 const char * dnf_sack_get_arch              (DnfSack    *sack);
 void         dnf_sack_set_provides_not_ready(DnfSack    *sack);
@@ -39,7 +39,10 @@
 #include <unistd.h>
 #include <iostream>
 #include <list>
+#include <map>
 #include <set>
+#include <tuple>
+#include <unordered_map>
 
 extern "C" {
 #include <solv/evr.h>
@@ -89,6 +92,24 @@ extern "C" {
 #define DEFAULT_CACHE_ROOT "/var/cache/hawkey"
 #define DEFAULT_CACHE_USER "/var/tmp/hawkey"
 
+/* reverse index of one rco key (requires, recommends, ...): dependency name -> packages */
+struct RcoIndex {
+    std::unordered_map<Id, std::vector<Id>> byName;
+    std::vector<Id> alwaysCandidates;   /* packages with deps that cannot be keyed by name */
+};
+
+/* installed packages by name and by name and arch, each list sorted by EVR and Id */
+struct InstalledIndex {
+    std::unordered_map<Id, std::vector<Id>> byName;
+    std::unordered_map<uint64_t, std::vector<Id>> byNameArch;
+};
+
+/* answers of dnf_sack_is_module_applicable() by (name, stream, context) */
+struct ModuleApplicability {
+    unsigned long generation;
+    std::map<std::tuple<Id, Id, Id>, bool> applicable;
+};
+
 typedef struct
 {
     Id                   running_kernel_id;
@@ -103,6 +124,10 @@ typedef struct
     Queue                installonly;
     Repo                *cmdline_repo;
     gboolean             considered_uptodate;
+    Map                 *considered_delta;  /* pkgs to recompute in an up to date considered map */
+    guint                considered_version;    /* bumped with every change of excludes/includes */
+    Map                 *considered_variants[4];   /* considered maps indexed by ExcludeFlags */
+    guint                considered_variants_version[4];
     gboolean             have_set_arch;
     gboolean             all_arch;
     gboolean             provides_ready;
@@ -112,6 +137,11 @@ typedef struct
     dnf_sack_running_kernel_fn_t  running_kernel_fn;
     guint                installonly_limit;
     libdnf::ModulePackageContainer * moduleContainer;
+    ModuleApplicability *module_applicability;  /* dropped with moduleContainer or its active set */
+    std::map<Id, RcoIndex> *rco_index;  /* lazily built per rco key, dropped with provides */
+    InstalledIndex      *installed_index;   /* lazily built, dropped with provides */
+    std::vector<int>    *evr_ranks;         /* evr Id -> ordinal in rpm version ordering */
+    int                  index_nsolvables;  /* Number of nsolvables for creation of indexes */
 } DnfSackPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(DnfSack, dnf_sack, G_TYPE_OBJECT)
@@ -146,11 +176,18 @@ dnf_sack_finalize(GObject *object)
     free_map_fully(priv->module_excludes);
     free_map_fully(priv->module_includes);
     free_map_fully(pool->considered);
+    free_map_fully(priv->considered_delta);
+    for (auto variant : priv->considered_variants)
+        free_map_fully(variant);
     free_map_fully(priv->pkg_solvables);
     pool_free(priv->pool);
     if (priv->moduleContainer) {
         delete priv->moduleContainer;
     }
+    delete priv->module_applicability;
+    delete priv->rco_index;
+    delete priv->installed_index;
+    delete priv->evr_ranks;
 
     G_OBJECT_CLASS(dnf_sack_parent_class)->finalize(object);
 }
@@ -188,6 +225,7 @@ dnf_sack_init(DnfSack *sack)
     priv->running_kernel_id = -1;
     priv->running_kernel_fn = running_kernel;
     priv->considered_uptodate = TRUE;
+    priv->considered_version = 1;
     priv->cmdline_repo = NULL;
     priv->allow_vendor_change = TRUE;
     queue_init(&priv->installonly);
@@ -362,6 +400,79 @@ dnf_sack_recompute_considered_map(DnfSack * sack, Map ** considered, libdnf::Que
     }
 }
 
+static inline bool
+map_has(const Map *m, Id id)
+{
+    return m && id < (m->size << 3) && MAPTST(m, id);
+}
+
+/* Tells whether the package passes excludes and includes, see dnf_sack_recompute_considered_map() */
+static bool
+considered_tst(DnfSackPrivate *priv, Id id, libdnf::Query::ExcludeFlags flags)
+{
+    if (!static_cast<bool>(flags & libdnf::Query::ExcludeFlags::IGNORE_MODULAR_EXCLUDES)
+        && map_has(priv->module_excludes, id))
+        return false;
+    if (!static_cast<bool>(flags & libdnf::Query::ExcludeFlags::IGNORE_REGULAR_EXCLUDES)) {
+        if (map_has(priv->repo_excludes, id) || map_has(priv->pkg_excludes, id))
+            return false;
+        if (priv->pkg_includes && !map_has(priv->pkg_includes, id)) {
+            Solvable *solvable = pool_id2solvable(priv->pool, id);
+            if (!solvable->repo)
+                return false;
+            auto hyrepo = static_cast<HyRepo>(solvable->repo->appdata);
+            if (hyrepo->getUseIncludes())
+                return false;
+        }
+    }
+    return true;
+}
+
+/* Mark the considered maps for a full recompute */
+static void
+considered_invalidate(DnfSackPrivate *priv)
+{
+    priv->considered_uptodate = FALSE;
+    priv->considered_version++;
+}
+
+/* Mark the considered state of packages in pkgmap for an incremental recompute */
+static void
+considered_invalidate_pkgs(DnfSackPrivate *priv, const Map *pkgmap)
+{
+    priv->considered_version++;
+    if (!priv->considered_uptodate)
+        return;
+    if (!priv->considered_delta) {
+        priv->considered_delta = static_cast<Map *>(g_malloc0(sizeof(Map)));
+        map_init(priv->considered_delta, priv->pool->nsolvables);
+    }
+    map_or(priv->considered_delta, pkgmap);
+}
+
+/* Recompute the considered state only for packages in delta */
+static void
+considered_apply_delta(DnfSackPrivate *priv, Map *considered, const Map *delta,
+                       libdnf::Query::ExcludeFlags flags)
+{
+    Pool *pool = priv->pool;
+    map_grow(considered, pool->nsolvables);
+    int nbytes = std::min(delta->size, (pool->nsolvables + 7) >> 3);
+    for (int byte = 0; byte < nbytes; ++byte) {
+        if (!delta->map[byte])
+            continue;
+        for (int bit = 0; bit < 8; ++bit) {
+            Id id = (byte << 3) + bit;
+            if (!(delta->map[byte] & (1 << bit)) || id >= pool->nsolvables)
+                continue;
+            if (considered_tst(priv, id, flags))
+                MAPSET(considered, id);
+            else
+                MAPCLR(considered, id);
+        }
+    }
+}
+
 /**
  * dnf_sack_recompute_considered:
  * @sack: a #DnfSack instance.
@@ -375,13 +486,45 @@ dnf_sack_recompute_considered(DnfSack *sack)
 {
     DnfSackPrivate *priv = GET_PRIVATE(sack);
     Pool *pool = dnf_sack_get_pool(sack);
-    if (priv->considered_uptodate)
+    if (priv->considered_uptodate) {
+        if (!priv->considered_delta)
+            return;
+        if (!pool->considered) {
+            // no considered map means that everything was considered
+            pool->considered = static_cast<Map *>(g_malloc0(sizeof(Map)));
+            map_init(pool->considered, pool->nsolvables);
+            map_setall(pool->considered);
+        }
+        considered_apply_delta(priv, pool->considered, priv->considered_delta,
+                               libdnf::Query::ExcludeFlags::APPLY_EXCLUDES);
+        priv->considered_delta = free_map_fully(priv->considered_delta);
         return;
+    }
     dnf_sack_recompute_considered_map(
         sack, &pool->considered, libdnf::Query::ExcludeFlags::APPLY_EXCLUDES);
+    priv->considered_delta = free_map_fully(priv->considered_delta);
     priv->considered_uptodate = TRUE;
 }
 
+const Map *
+dnf_sack_get_considered_map(DnfSack *sack, libdnf::Query::ExcludeFlags flags)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool *pool = dnf_sack_get_pool(sack);
+    if (flags == libdnf::Query::ExcludeFlags::APPLY_EXCLUDES) {
+        dnf_sack_recompute_considered(sack);
+        return pool->considered;
+    }
+    auto variant = static_cast<int>(flags);
+    if (priv->considered_variants_version[variant] != priv->considered_version ||
+        (priv->considered_variants[variant] &&
+         priv->considered_variants[variant]->size < (pool->nsolvables + 7) >> 3)) {
+        dnf_sack_recompute_considered_map(sack, &priv->considered_variants[variant], flags);
+        priv->considered_variants_version[variant] = priv->considered_version;
+    }
+    return priv->considered_variants[variant];
+}
+
 static gboolean
 load_ext(DnfSack *sack, HyRepo hrepo, _hy_repo_repodata which_repodata,
          const char *suffix, const char * which_filename,
@@ -1269,7 +1412,7 @@ dnf_sack_add_cmdline_package_flags(DnfSack *sack, const char *fn, const int flag
     }
     auto hrepo = static_cast<HyRepo>(repo->appdata);
     libdnf::repoGetImpl(hrepo)->needs_internalizing = 1;
-    priv->considered_uptodate = FALSE;   /* triggers recompute_considered later */
+    considered_invalidate(priv);   /* triggers recompute_considered later */
     return dnf_package_new(sack, p);
 }
 
@@ -1324,7 +1467,10 @@ dnf_sack_count(DnfSack *sack)
 static void
 dnf_sack_add_excludes_or_includes(DnfSack *sack, Map **dest, const DnfPackageSet *pkgset)
 {
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
     Map *destmap = *dest;
+    // the first includes restrict also packages outside of pkgset
+    bool structural = destmap == NULL && dest == &priv->pkg_includes;
     if (destmap == NULL) {
         destmap = static_cast<Map *>(g_malloc0(sizeof(Map)));
         Pool *pool = dnf_sack_get_pool(sack);
@@ -1334,8 +1480,10 @@ dnf_sack_add_excludes_or_includes(DnfSack *sack, Map **dest, const DnfPackageSet
 
     auto pkgmap = pkgset->getMap();
     map_or(destmap, pkgmap);
-    DnfSackPrivate *priv = GET_PRIVATE(sack);
-    priv->considered_uptodate = FALSE;
+    if (structural)
+        considered_invalidate(priv);
+    else
+        considered_invalidate_pkgs(priv, pkgmap);
 }
 
 /**
@@ -1394,7 +1542,7 @@ dnf_sack_remove_excludes_or_includes(DnfSack *sack, Map *from, const DnfPackageS
     auto pkgmap = pkgset->getMap();
     map_subtract(from, pkgmap);
     DnfSackPrivate *priv = GET_PRIVATE(sack);
-    priv->considered_uptodate = FALSE;
+    considered_invalidate_pkgs(priv, pkgmap);
 }
 
 /**
@@ -1451,14 +1599,27 @@ dnf_sack_set_excludes_or_includes(DnfSack *sack, Map **dest, const DnfPackageSet
     if (*dest == NULL && pkgset == NULL)
         return;
 
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    // setting or resetting includes changes also packages outside of both sets
+    if (dest == &priv->pkg_includes && (*dest == NULL || pkgset == NULL)) {
+        considered_invalidate(priv);
+    } else {
+        // only packages in the old or in the new set can change their state
+        Map changed;
+        map_init(&changed, priv->pool->nsolvables);
+        if (*dest)
+            map_or(&changed, *dest);
+        if (pkgset)
+            map_or(&changed, pkgset->getMap());
+        considered_invalidate_pkgs(priv, &changed);
+        map_free(&changed);
+    }
     *dest = free_map_fully(*dest);
     if (pkgset) {
         *dest = static_cast<Map *>(g_malloc0(sizeof(Map)));
         auto pkgmap = pkgset->getMap();
         map_init_clone(*dest, pkgmap);
     }
-    DnfSackPrivate *priv = GET_PRIVATE(sack);
-    priv->considered_uptodate = FALSE;
 }
 
 void
@@ -1654,7 +1815,7 @@ dnf_sack_set_use_includes(DnfSack *sack, const char *reponame, gboolean enabled)
         if (hyrepo->getUseIncludes() != enabled)
         {
             hyrepo->setUseIncludes(enabled);
-            priv->considered_uptodate = FALSE;
+            considered_invalidate(priv);
         }
     } else {
         Id repoid;
@@ -1664,7 +1825,7 @@ dnf_sack_set_use_includes(DnfSack *sack, const char *reponame, gboolean enabled)
             if (hyrepo->getUseIncludes() != enabled)
             {
                 hyrepo->setUseIncludes(enabled);
-                priv->considered_uptodate = FALSE;
+                considered_invalidate(priv);
             }
         }
     }
@@ -1698,7 +1859,7 @@ void
 dnf_sack_set_considered_to_update(DnfSack *sack)
 {
     DnfSackPrivate *priv = GET_PRIVATE(sack);
-    priv->considered_uptodate = FALSE;
+    considered_invalidate(priv);
 }
 
 /**
@@ -1762,7 +1923,7 @@ dnf_sack_repo_enabled(DnfSack *sack, const char *reponame, int enabled)
     else
         FOR_REPO_SOLVABLES(repo, p, s)
             MAPCLR(priv->repo_excludes, p);
-    priv->considered_uptodate = FALSE;
+    considered_invalidate(priv);
     return 0;
 }
 
@@ -1773,7 +1934,9 @@ dnf_sack_repo_enabled(DnfSack *sack, const char *reponame, int enabled)
  * @flags: what to load into the sack, e.g. %DNF_SACK_LOAD_FLAG_USE_FILELISTS.
  * @error: a #GError or %NULL.
  *
- * Loads the rpmdb into the sack.
+ * Loads the rpmdb into the sack. With %DNF_SACK_LOAD_FLAG_BUILD_CACHE the loaded
+ * rpmdb together with file provides added later is cached in the cache directory
+ * and the cache is used instead of the rpmdb until the rpmdb changes.
  *
  * Returns: %TRUE for success
  *
@@ -1796,23 +1959,49 @@ dnf_sack_load_system_repo(DnfSack *sack, HyRepo a_hrepo, int flags, GError **err
         hrepo = hy_repo_create(HY_SYSTEM_REPO_NAME);
     auto repoImpl = libdnf::repoGetImpl(hrepo);
 
-    repoImpl->load_flags = flags &= ~DNF_SACK_LOAD_FLAG_BUILD_CACHE;
+    // with BUILD_CACHE the loaded rpmdb is cached (including added file provides) and reused
+    // until the rpmdb changes
+    const int build_cache = flags & DNF_SACK_LOAD_FLAG_BUILD_CACHE;
+    repoImpl->load_flags = flags;
 
     repo = repo_create(pool, HY_SYSTEM_REPO_NAME);
 
-    g_debug("fetching rpmdb");
-    int flagsrpm = REPO_REUSE_REPODATA | RPM_ADD_WITH_HDRID | REPO_USE_ROOTDIR;
-    int rc = repo_add_rpmdb_reffp(repo, NULL, flagsrpm);
-    if (!rc) {
-        repoImpl->state_main = _HY_LOADED_FETCH;
-    } else {
-        repo_free(repo, 1);
-        ret = FALSE;
-        g_set_error (error,
-                     DNF_ERROR,
-                     DNF_ERROR_FILE_INVALID,
-                     _("failed loading RPMDB"));
-        goto finish;
+    g_autofree gchar *fn_cache = nullptr;
+    bool from_cache = false;
+    if (build_cache) {
+        fn_cache = dnf_sack_give_cache_fn(sack, HY_SYSTEM_REPO_NAME, NULL);
+        GError *error_local = NULL;
+        if (checksum_rpmdb(repoImpl->checksum, pool_get_rootdir(pool)) == 0 &&
+            try_to_use_cached_solvfile(fn_cache, repo, 0, repoImpl->checksum, &error_local)) {
+            g_debug("using cached %s (0x%s)", HY_SYSTEM_REPO_NAME,
+                    pool_checksum_str(pool, repoImpl->checksum));
+            repoImpl->state_main = _HY_LOADED_CACHE;
+            from_cache = true;
+        } else if (error_local) {
+            g_warning("Failed to use rpmdb cache %s: %s", fn_cache, error_local->message);
+            g_clear_error(&error_local);
+        }
+    }
+
+    if (!from_cache) {
+        g_debug("fetching rpmdb");
+        int flagsrpm = REPO_REUSE_REPODATA | RPM_ADD_WITH_HDRID | REPO_USE_ROOTDIR;
+        // an outdated cache still provides data of unchanged headers
+        FILE *fp_ref = fn_cache ? fopen(fn_cache, "r") : NULL;
+        int rc = repo_add_rpmdb_reffp(repo, fp_ref, flagsrpm);
+        if (fp_ref)
+            fclose(fp_ref);
+        if (!rc) {
+            repoImpl->state_main = _HY_LOADED_FETCH;
+        } else {
+            repo_free(repo, 1);
+            ret = FALSE;
+            g_set_error (error,
+                         DNF_ERROR,
+                         DNF_ERROR_FILE_INVALID,
+                         _("failed loading RPMDB"));
+            goto finish;
+        }
     }
 
     libdnf::repoGetImpl(hrepo)->attachLibsolvRepo(repo);
@@ -1822,7 +2011,16 @@ dnf_sack_load_system_repo(DnfSack *sack, HyRepo a_hrepo, int flags, GError **err
     repoImpl->main_nsolvables = repo->nsolvables;
     repoImpl->main_nrepodata = repo->nrepodata;
     repoImpl->main_end = repo->end;
-    priv->considered_uptodate = FALSE;
+    considered_invalidate(priv);
+
+    if (build_cache && !from_cache) {
+        GError *error_local = NULL;
+        if (!write_main(sack, hrepo, 0, &error_local)) {
+            // the cache is an optimization only, the rpmdb is loaded anyway
+            g_warning("Failed to write rpmdb cache: %s", error_local->message);
+            g_clear_error(&error_local);
+        }
+    }
 
  finish:
     if (a_hrepo == NULL)
@@ -1830,6 +2028,148 @@ dnf_sack_load_system_repo(DnfSack *sack, HyRepo a_hrepo, int flags, GError **err
     return ret;
 } CATCH_TO_GERROR(FALSE)
 
+/* Number of ids in the pool which do not belong to any repo anymore. */
+static int
+pool_count_freed_solvables(Pool *pool)
+{
+    int freed = 0;
+    for (Id p = 2; p < pool->nsolvables; ++p) {
+        if (!pool_id2solvable(pool, p)->repo)
+            ++freed;
+    }
+    return freed;
+}
+
+/**
+ * dnf_sack_reload_system_repo:
+ * @sack: a #DnfSack instance.
+ * @error: a #GError or %NULL.
+ *
+ * Reloads the rpmdb into the already loaded system repo after the rpmdb changed. Only the
+ * system repo is emptied and filled again, available repos stay loaded in the pool. Provides
+ * and considered packages are computed again. Solvable ids of installed packages are not
+ * preserved, package sets and goals created before the reload must be dropped. Excludes and
+ * includes of installed packages are kept for packages which stay installed.
+ * The ids of the previous installed packages are reused only when the system repo is the last
+ * repo of the pool, otherwise they stay unused. Once the pool holds as many unused ids as the
+ * system repo has packages, the reload fails with %DNF_ERROR_NO_CAPABILITY and leaves the sack
+ * untouched, the caller is expected to set up a new sack.
+ * When the system repo was not loaded yet, it is loaded.
+ *
+ * Returns: %TRUE for success
+ *
+ * Since: 0.70.2
+ */
+gboolean
+dnf_sack_reload_system_repo(DnfSack *sack, GError **error) try
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool *pool = priv->pool;
+    Repo *repo = pool->installed;
+
+    if (repo == NULL || repo->appdata == NULL)
+        return dnf_sack_load_system_repo(sack, NULL, DNF_SACK_LOAD_FLAG_NONE, error);
+
+    auto hrepo = static_cast<HyRepo>(repo->appdata);
+    auto repoImpl = libdnf::repoGetImpl(hrepo);
+    const int build_cache = repoImpl->load_flags & DNF_SACK_LOAD_FLAG_BUILD_CACHE;
+
+    if (repo->nsolvables > 0 && repo->end != pool->nsolvables &&
+        pool_count_freed_solvables(pool) >= repo->nsolvables) {
+        g_set_error(error,
+                    DNF_ERROR,
+                    DNF_ERROR_NO_CAPABILITY,
+                    _("cannot reload the rpmdb into the sack without growing the pool"));
+        return FALSE;
+    }
+
+    g_debug("reloading rpmdb");
+
+    // excludes and includes of installed packages follow them to their new ids, they are
+    // matched by the rpmdb header number
+    Map *id_maps[] = {priv->pkg_excludes, priv->pkg_includes,
+                      priv->module_excludes, priv->module_includes};
+    std::unordered_map<Id, unsigned> id_maps_bits;
+    Id p;
+    Solvable *s;
+    FOR_REPO_SOLVABLES(repo, p, s) {
+        unsigned bits = 0;
+        for (unsigned i = 0; i < G_N_ELEMENTS(id_maps); ++i) {
+            if (map_has(id_maps[i], p)) {
+                bits |= 1 << i;
+                MAPCLR(id_maps[i], p);
+            }
+        }
+        if (bits && repo->rpmdbid)
+            id_maps_bits[repo->rpmdbid[p - repo->start]] = bits;
+        if (map_has(priv->repo_excludes, p))
+            MAPCLR(priv->repo_excludes, p);
+    }
+
+    repo_empty(repo, 1);
+    priv->provides_ready = 0;
+    priv->running_kernel_id = -1;
+    delete priv->evr_ranks;
+    priv->evr_ranks = nullptr;
+
+    g_autofree gchar *fn_cache = nullptr;
+    if (build_cache)
+        fn_cache = dnf_sack_give_cache_fn(sack, HY_SYSTEM_REPO_NAME, NULL);
+    int flagsrpm = REPO_REUSE_REPODATA | RPM_ADD_WITH_HDRID | REPO_USE_ROOTDIR;
+    // the cache written on the previous load provides data of unchanged headers
+    FILE *fp_ref = fn_cache ? fopen(fn_cache, "r") : NULL;
+    int rc = repo_add_rpmdb_reffp(repo, fp_ref, flagsrpm);
+    if (fp_ref)
+        fclose(fp_ref);
+    if (rc) {
+        considered_invalidate(priv);
+        g_set_error (error,
+                     DNF_ERROR,
+                     DNF_ERROR_FILE_INVALID,
+                     _("failed loading RPMDB"));
+        return FALSE;
+    }
+    repoImpl->state_main = _HY_LOADED_FETCH;
+    repoImpl->main_nsolvables = repo->nsolvables;
+    repoImpl->main_nrepodata = repo->nrepodata;
+    repoImpl->main_end = repo->end;
+
+    for (auto id_map : id_maps) {
+        if (id_map)
+            map_grow(id_map, pool->nsolvables);
+    }
+    FOR_REPO_SOLVABLES(repo, p, s) {
+        if (!id_maps_bits.empty() && repo->rpmdbid) {
+            auto bits = id_maps_bits.find(repo->rpmdbid[p - repo->start]);
+            if (bits != id_maps_bits.end()) {
+                for (unsigned i = 0; i < G_N_ELEMENTS(id_maps); ++i) {
+                    if (bits->second & (1 << i))
+                        MAPSET(id_maps[i], p);
+                }
+            }
+        }
+        if (repo->disabled && priv->repo_excludes) {
+            map_grow(priv->repo_excludes, pool->nsolvables);
+            MAPSET(priv->repo_excludes, p);
+        }
+    }
+    // the cached set of all packages is valid only for the same pool size
+    priv->pool_nsolvables = 0;
+    considered_invalidate(priv);
+
+    if (build_cache && checksum_rpmdb(repoImpl->checksum, pool_get_rootdir(pool)) == 0) {
+        GError *error_local = NULL;
+        if (!write_main(sack, hrepo, 0, &error_local)) {
+            g_warning("Failed to write rpmdb cache: %s", error_local->message);
+            g_clear_error(&error_local);
+        }
+    }
+
+    dnf_sack_make_provides_ready(sack);
+    dnf_sack_recompute_considered(sack);
+    return TRUE;
+} CATCH_TO_GERROR(FALSE)
+
 /**
  * dnf_sack_load_repo:
  * @sack: a #DnfSack instance.
@@ -1948,7 +2288,7 @@ dnf_sack_load_repo(DnfSack *sack, HyRepo repo, int flags, GError **error) try
             if (!write_ext(sack, repo, _HY_REPODATA_UPDATEINFO, HY_EXT_UPDATEINFO, error))
                 return FALSE;
     }
-    priv->considered_uptodate = FALSE;
+    considered_invalidate(priv);
     return TRUE;
 } CATCH_TO_GERROR(FALSE)
 
@@ -2029,6 +2369,15 @@ rewrite_repos(DnfSack *sack, Queue *addedfileprovides,
     map_free(&providedids);
 }
 
+static void
+drop_indexes(DnfSackPrivate *priv)
+{
+    if (priv->rco_index)
+        priv->rco_index->clear();
+    delete priv->installed_index;
+    priv->installed_index = nullptr;
+}
+
 /**
  * dnf_sack_make_provides_ready:
  * @sack: a #DnfSack instance.
@@ -2057,6 +2406,192 @@ dnf_sack_make_provides_ready(DnfSack *sack)
     queue_free(&addedfileprovides_inst);
     pool_createwhatprovides(priv->pool);
     priv->provides_ready = 1;
+    drop_indexes(priv);
+}
+
+/* Drop indexes of pool content also when solvables were added without resetting provides */
+static void
+check_indexes(DnfSackPrivate *priv)
+{
+    if (priv->index_nsolvables != priv->pool->nsolvables) {
+        drop_indexes(priv);
+        delete priv->evr_ranks;
+        priv->evr_ranks = nullptr;
+        priv->index_nsolvables = priv->pool->nsolvables;
+    }
+}
+
+const std::vector<int> &
+dnf_sack_get_evr_ranks(DnfSack *sack)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool *pool = priv->pool;
+
+    // EVRs do not depend on provides, the table survives until new solvables appear
+    check_indexes(priv);
+    if (priv->evr_ranks)
+        return *priv->evr_ranks;
+
+    std::vector<Id> evrs;
+    evrs.reserve(pool->nsolvables);
+    for (Id p = 2; p < pool->nsolvables; ++p) {
+        Solvable *s = pool->solvables + p;
+        if (s->repo)
+            evrs.push_back(s->evr);
+    }
+    std::sort(evrs.begin(), evrs.end());
+    evrs.erase(std::unique(evrs.begin(), evrs.end()), evrs.end());
+    std::sort(evrs.begin(), evrs.end(), [pool](Id a, Id b) {
+        return pool_evrcmp(pool, a, b, EVRCMP_COMPARE) < 0;
+    });
+
+    // rank 0 is reserved for EVRs unknown to the table
+    auto ranks = new std::vector<int>(pool->ss.nstrings, 0);
+    int rank = 0;
+    for (size_t i = 0; i < evrs.size(); ++i) {
+        if (i == 0 || pool_evrcmp(pool, evrs[i - 1], evrs[i], EVRCMP_COMPARE) != 0)
+            ++rank;
+        (*ranks)[evrs[i]] = rank;
+    }
+    priv->evr_ranks = ranks;
+    return *ranks;
+}
+
+/* Collect names which pool_match_dep() can compare when matching dep. Both sides of rich
+ * dependencies are collected, so the result is a superset of really matching names. */
+static void
+rco_dep_names(Pool *pool, Id dep, std::vector<Id> & names, bool & keyable)
+{
+    while (ISRELDEP(dep)) {
+        Reldep *rd = GETRELDEP(pool, dep);
+        switch (rd->flags) {
+            case REL_AND:
+            case REL_OR:
+            case REL_WITH:
+            case REL_WITHOUT:
+            case REL_COND:
+            case REL_UNLESS:
+            case REL_ELSE:
+                rco_dep_names(pool, rd->evr, names, keyable);
+                break;
+            case REL_NAMESPACE:
+                // providers of namespace deps are resolved by a callback, not by name
+                keyable = false;
+                break;
+            default:
+                break;
+        }
+        dep = rd->name;
+    }
+    names.push_back(dep);
+}
+
+static RcoIndex &
+rco_index_get(DnfSack *sack, Id rcoKey)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool *pool = priv->pool;
+
+    check_indexes(priv);
+    if (!priv->rco_index)
+        priv->rco_index = new std::map<Id, RcoIndex>;
+    auto it = priv->rco_index->find(rcoKey);
+    if (it != priv->rco_index->end())
+        return it->second;
+
+    auto & index = (*priv->rco_index)[rcoKey];
+    Queue deps;
+    queue_init(&deps);
+    std::vector<Id> names;
+    Id p;
+    FOR_PKG_SOLVABLES(p) {
+        queue_empty(&deps);
+        solvable_lookup_idarray(pool_id2solvable(pool, p), rcoKey, &deps);
+        names.clear();
+        bool keyable = true;
+        for (int i = 0; i < deps.count; ++i)
+            rco_dep_names(pool, deps.elements[i], names, keyable);
+        if (!keyable) {
+            index.alwaysCandidates.push_back(p);
+            continue;
+        }
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        for (auto name : names)
+            index.byName[name].push_back(p);
+    }
+    queue_free(&deps);
+    return index;
+}
+
+void
+dnf_sack_get_rco_candidates(DnfSack *sack, Id rcoKey, Id dep, Queue *candidates)
+{
+    Pool *pool = dnf_sack_get_pool(sack);
+    auto & index = rco_index_get(sack, rcoKey);
+
+    std::vector<Id> names;
+    bool keyable = true;
+    rco_dep_names(pool, dep, names, keyable);
+    for (auto name : names) {
+        auto it = index.byName.find(name);
+        if (it == index.byName.end())
+            continue;
+        for (auto p : it->second)
+            queue_push(candidates, p);
+    }
+    for (auto p : index.alwaysCandidates)
+        queue_push(candidates, p);
+}
+
+static inline uint64_t
+name_arch_key(Id name, Id arch)
+{
+    return (static_cast<uint64_t>(name) << 32) | static_cast<uint32_t>(arch);
+}
+
+static InstalledIndex &
+installed_index_get(DnfSack *sack)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    Pool *pool = priv->pool;
+
+    check_indexes(priv);
+    if (priv->installed_index)
+        return *priv->installed_index;
+
+    auto index = new InstalledIndex;
+    priv->installed_index = index;
+    if (!pool->installed)
+        return *index;
+
+    Id p;
+    Solvable *s;
+    FOR_REPO_SOLVABLES(pool->installed, p, s) {
+        index->byName[s->name].push_back(p);
+        index->byNameArch[name_arch_key(s->name, s->arch)].push_back(p);
+    }
+    auto evrIdCmp = [pool](Id a, Id b) {
+        int cmp = pool_evrcmp(pool, pool->solvables[a].evr, pool->solvables[b].evr, EVRCMP_COMPARE);
+        return cmp ? cmp < 0 : a < b;
+    };
+    for (auto & item : index->byName)
+        std::sort(item.second.begin(), item.second.end(), evrIdCmp);
+    for (auto & item : index->byNameArch)
+        std::sort(item.second.begin(), item.second.end(), evrIdCmp);
+    return *index;
+}
+
+const std::vector<Id> *
+dnf_sack_get_installed_by_name(DnfSack *sack, Id name, Id arch)
+{
+    auto & index = installed_index_get(sack);
+    if (arch) {
+        auto it = index.byNameArch.find(name_arch_key(name, arch));
+        return it == index.byNameArch.end() ? nullptr : &it->second;
+    }
+    auto it = index.byName.find(name);
+    return it == index.byName.end() ? nullptr : &it->second;
 }
 
 /**
@@ -2113,6 +2648,8 @@ dnf_sack_set_module_container(DnfSack *sack, libdnf::ModulePackageContainer * ne
     DnfSackPrivate *priv = GET_PRIVATE(sack);
     auto oldConteiner = priv->moduleContainer;
     priv->moduleContainer = newConteiner;
+    delete priv->module_applicability;
+    priv->module_applicability = nullptr;
     return oldConteiner;
 }
 
@@ -2133,6 +2670,43 @@ dnf_sack_get_module_container(DnfSack *sack)
     return priv->moduleContainer;
 }
 
+bool
+dnf_sack_is_module_applicable(DnfSack *sack, Id name, Id stream, Id context)
+{
+    DnfSackPrivate *priv = GET_PRIVATE(sack);
+    auto moduleContainer = priv->moduleContainer;
+    if (!moduleContainer)
+        return false;
+
+    auto generation = moduleContainer->getActiveGeneration();
+    auto cache = priv->module_applicability;
+    if (!cache) {
+        cache = new ModuleApplicability;
+        cache->generation = generation;
+        priv->module_applicability = cache;
+    } else if (cache->generation != generation) {
+        cache->applicable.clear();
+        cache->generation = generation;
+    }
+
+    auto key = std::make_tuple(name, stream, context);
+    auto it = cache->applicable.find(key);
+    if (it != cache->applicable.end())
+        return it->second;
+
+    Pool *pool = priv->pool;
+    bool applicable = false;
+    for (auto module : moduleContainer->query(pool_id2str(pool, name), pool_id2str(pool, stream),
+                                              {}, pool_id2str(pool, context), {})) {
+        if (moduleContainer->isModuleActive(module)) {
+            applicable = true;
+            break;
+        }
+    }
+    cache->applicable.emplace(key, applicable);
+    return applicable;
+}
+
 /**********************************************************************/
 
 static void
@@ -2584,6 +3158,8 @@ std::pair<std::vector<std::vector<std::string>>, libdnf::ModulePackageContainer:
             if (priv->moduleContainer) {
                 delete priv->moduleContainer;
             }
+            delete priv->module_applicability;
+            priv->module_applicability = nullptr;
             priv->moduleContainer = new libdnf::ModulePackageContainer(dnf_sack_get_all_arch(sack),
                 install_root, dnf_sack_get_arch(sack));
             moduleContainer = priv->moduleContainer;
@@ -103,6 +103,14 @@ typedef struct
     guint64          *speed_data;
     guint             current;
     guint             last_percentage;
+    guint             emitted_percentage;
+    gint64            emitted_percentage_time;
+    guint             throttle_percentage;
+    guint             throttle_interval;
+    gchar            *progress_package_id;
+    DnfStateAction    progress_action;
+    guint             progress_percentage;
+    gint64            progress_time;
     guint            *step_data;
     guint             steps;
     gulong            action_child_id;
@@ -156,6 +164,7 @@ dnf_state_finalize(GObject *object)
     dnf_state_reset(state);
     g_free(priv->id);
     g_free(priv->action_hint);
+    g_free(priv->progress_package_id);
     g_free(priv->step_data);
     g_free(priv->step_profile);
     if (priv->cancellable != NULL)
@@ -317,6 +326,58 @@ dnf_state_set_enable_profile(DnfState *state, gboolean enable_profile)
     priv->enable_profile = enable_profile;
 }
 
+/**
+ * dnf_state_set_progress_throttle:
+ * @state: A #DnfState
+ * @percentage_delta: the minimum change in percentage to emit, or 0
+ * @interval_ms: the minimum time between emits in milliseconds, or 0
+ *
+ * Limits how often the percentage-changed and package-progress-changed
+ * signals are emitted. A new value is only emitted when it differs from the
+ * last emitted one by at least @percentage_delta, or when at least
+ * @interval_ms passed since the last emit. Values in between are coalesced,
+ * 0% and 100% are always emitted.
+ *
+ * Child states returned by dnf_state_get_child() use the same limits.
+ * Both limits set to 0, the default, emit every change.
+ *
+ * Since: 0.70.2
+ **/
+void
+dnf_state_set_progress_throttle(DnfState *state, guint percentage_delta, guint interval_ms)
+{
+    DnfStatePrivate *priv = GET_PRIVATE(state);
+    priv->throttle_percentage = percentage_delta;
+    priv->throttle_interval = interval_ms;
+}
+
+/**
+ * dnf_state_progress_throttled:
+ *
+ * Returns: %TRUE if @percentage should not be emitted yet
+ **/
+static gboolean
+dnf_state_progress_throttled(DnfStatePrivate *priv,
+                             guint percentage,
+                             guint emitted_percentage,
+                             gint64 emitted_time)
+{
+    if (priv->throttle_percentage == 0 && priv->throttle_interval == 0)
+        return FALSE;
+
+    /* the start and the end are always interesting */
+    if (percentage == 0 || percentage == 100)
+        return FALSE;
+
+    if (priv->throttle_percentage > 0 &&
+        percentage >= emitted_percentage + priv->throttle_percentage)
+        return FALSE;
+    if (priv->throttle_interval > 0 &&
+        g_get_monotonic_time() - emitted_time >= (gint64) priv->throttle_interval * 1000)
+        return FALSE;
+    return TRUE;
+}
+
 /**
  * dnf_state_take_lock:
  * @state: A #DnfState
@@ -630,6 +691,15 @@ dnf_state_set_percentage(DnfState *state, guint percentage)
     /* save */
     priv->last_percentage = percentage;
 
+    /* coalesce with the next change */
+    if (dnf_state_progress_throttled(priv, percentage,
+                                     priv->emitted_percentage,
+                                     priv->emitted_percentage_time))
+        return FALSE;
+    priv->emitted_percentage = percentage;
+    if (priv->throttle_interval > 0)
+        priv->emitted_percentage_time = g_get_monotonic_time();
+
     /* emit */
     g_signal_emit(state, signals [SIGNAL_PERCENTAGE_CHANGED], 0, percentage);
 
@@ -721,11 +791,31 @@ dnf_state_set_package_progress(DnfState *state,
                 DnfStateAction action,
                 guint percentage)
 {
+    DnfStatePrivate *priv = GET_PRIVATE(state);
+
     g_return_if_fail(dnf_package_get_id != NULL);
     g_return_if_fail(action != DNF_STATE_ACTION_UNKNOWN);
     g_return_if_fail(percentage <= 100);
 
-    /* just emit */
+    /* coalesce with the next change of the same package */
+    if (priv->progress_action == action &&
+        g_strcmp0(priv->progress_package_id, dnf_package_get_id) == 0) {
+        if (percentage == priv->progress_percentage)
+            return;
+        if (dnf_state_progress_throttled(priv, percentage,
+                                         priv->progress_percentage,
+                                         priv->progress_time))
+            return;
+    } else if (priv->throttle_percentage > 0 || priv->throttle_interval > 0) {
+        g_free(priv->progress_package_id);
+        priv->progress_package_id = g_strdup(dnf_package_get_id);
+        priv->progress_action = action;
+    }
+    priv->progress_percentage = percentage;
+    if (priv->throttle_interval > 0)
+        priv->progress_time = g_get_monotonic_time();
+
+    /* emit */
     g_signal_emit(state, signals [SIGNAL_PACKAGE_PROGRESS_CHANGED], 0,
                dnf_package_get_id, action, percentage);
 }
@@ -936,6 +1026,7 @@ dnf_state_reset(DnfState *state)
     priv->steps = 0;
     priv->current = 0;
     priv->last_percentage = 0;
+    priv->emitted_percentage = 0;
 
     /* only use the timer if profiling; it's expensive */
     if (priv->enable_profile)
@@ -1060,6 +1151,7 @@ dnf_state_get_child(DnfState *state)
     /* reset child */
     child_priv->current = 0;
     child_priv->last_percentage = 0;
+    child_priv->emitted_percentage = 0;
 
     /* save so we can recover after child has done */
     child_priv->action = priv->action;
@@ -1072,6 +1164,9 @@ dnf_state_get_child(DnfState *state)
 
     /* set the profile state */
     dnf_state_set_enable_profile(child, priv->enable_profile);
+
+    /* emit as often as the parent */
+    dnf_state_set_progress_throttle(child, priv->throttle_percentage, priv->throttle_interval);
     return child;
 }
 
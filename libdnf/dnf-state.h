@@ -157,6 +157,9 @@ gboolean         dnf_state_finished_real                (DnfState
 gboolean         dnf_state_reset                        (DnfState               *state);
 void             dnf_state_set_enable_profile           (DnfState               *state,
                                                          gboolean                enable_profile);
+void             dnf_state_set_progress_throttle        (DnfState               *state,
+                                                         guint                   percentage_delta,
+                                                         guint                   interval_ms);
 #ifndef __GI_SCANNER__
 gboolean         dnf_state_take_lock                    (DnfState               *state,
                                                          DnfLockType             lock_type,
@@ -21,12 +21,19 @@
 #ifndef __GOAL_PRIVATE_HPP
 #define __GOAL_PRIVATE_HPP
 
+#include <map>
+#include <string>
+#include <tuple>
+
 #include "Goal.hpp"
 #include "IdQueue.hpp"
 #include "../sack/packageset.hpp"
 
 namespace libdnf {
 
+/// Rendered problem rules keyed by (rule type, source, target, dep)
+typedef std::map<std::tuple<int, Id, Id, Id>, std::string> ProblemRuleStrCache;
+
 class Goal::Impl {
 public:
     Impl(DnfSack * sack);
@@ -45,8 +52,9 @@ private:
     std::unique_ptr<PackageSet> protectedPkgs;
     bool protect_running_kernel{true};
     std::unique_ptr<PackageSet> removalOfProtected;
+    std::unique_ptr<ClassifiedResults> results;
 
-    PackageSet listResults(Id type_filter1, Id type_filter2);
+    const ClassifiedResults & classifyResults();
     void allowUninstallAllButProtected(Queue *job, DnfGoalActions flags);
     std::unique_ptr<IdQueue> constructJob(DnfGoalActions flags);
     bool solve(Queue *job, DnfGoalActions flags);
@@ -57,6 +65,8 @@ private:
     Id protectedRunningKernel();
     bool protectedInRemovals();
     std::string describeProtectedRemoval();
+    std::vector<std::string> describeProblemRules(unsigned i, bool pkgs, PackageSet * modularExcludes,
+        ProblemRuleStrCache & ruleStrCache);
     std::unique_ptr<PackageSet> brokenDependencyAllPkgs(DnfPackageState pkg_type);
     int countProblems();
 };
@@ -19,9 +19,11 @@
  */
 
 #include <assert.h>
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <numeric>
+#include <unordered_set>
 
 extern "C" {
 #include <solv/evr.h>
@@ -247,14 +249,21 @@ packageToJob(DnfPackage * package, Queue * job, int solver_action)
     queue_push2(job, SOLVER_SOLVABLE_ONE_OF|SOLVER_SETARCH|SOLVER_SETEVR|solver_action, what);
 }
 
-static int
-jobHas(Queue *job, Id what, Id id)
-{
-    for (int i = 0; i < job->count; i += 2)
-        if (job->elements[i] == what && job->elements[i + 1] == id)
-            return 1;
-    return 0;
-}
+/**
+ * Job entries pushed while a selector is turned into a job. The glob expansion can find the same
+ * name many times, the set keeps the de-duplication O(1) instead of scanning the whole job.
+ */
+class JobSeen {
+public:
+    bool insert(Id what, Id id)
+    {
+        return seen.insert(static_cast<uint64_t>(static_cast<uint32_t>(what)) << 32 |
+                           static_cast<uint32_t>(id)).second;
+    }
+
+private:
+    std::unordered_set<uint64_t> seen;
+};
 
 static int
 filterArchToJob(DnfSack *sack, const Filter *f, Queue *job)
@@ -348,7 +357,7 @@ filterPkgToJob(Id what, Queue *job)
 }
 
 static int
-filterNameToJob(DnfSack *sack, const Filter *f, Queue *job)
+filterNameToJob(DnfSack *sack, const Filter *f, Queue *job, JobSeen & seen)
 {
     if (!f)
         return 0;
@@ -363,7 +372,7 @@ filterNameToJob(DnfSack *sack, const Filter *f, Queue *job)
     switch (f->getCmpType()) {
     case HY_EQ:
         id = pool_str2id(pool, name, 0);
-        if (id)
+        if (id && seen.insert(SOLVER_SOLVABLE_NAME, id))
             queue_push2(job, SOLVER_SOLVABLE_NAME, id);
         break;
     case HY_GLOB:
@@ -373,7 +382,7 @@ filterNameToJob(DnfSack *sack, const Filter *f, Queue *job)
                 continue;
             assert(di.idp);
             id = *di.idp;
-            if (jobHas(job, SOLVABLE_NAME, id))
+            if (!seen.insert(SOLVER_SOLVABLE_NAME, id))
                 continue;
             queue_push2(job, SOLVER_SOLVABLE_NAME, id);
         }
@@ -386,7 +395,7 @@ filterNameToJob(DnfSack *sack, const Filter *f, Queue *job)
 }
 
 static int
-filterProvidesToJob(DnfSack *sack, const Filter *f, Queue *job)
+filterProvidesToJob(DnfSack *sack, const Filter *f, Queue *job, JobSeen & seen)
 {
     if (!f)
         return 0;
@@ -401,7 +410,8 @@ filterProvidesToJob(DnfSack *sack, const Filter *f, Queue *job)
     switch (f->getCmpType()) {
         case HY_EQ:
             id = matches[0].reldep;
-            queue_push2(job, SOLVER_SOLVABLE_PROVIDES, id);
+            if (seen.insert(SOLVER_SOLVABLE_PROVIDES, id))
+                queue_push2(job, SOLVER_SOLVABLE_PROVIDES, id);
             break;
         case HY_GLOB:
             name = matches[0].str;
@@ -412,7 +422,7 @@ filterProvidesToJob(DnfSack *sack, const Filter *f, Queue *job)
             }
             assert(di.idp);
             id = *di.idp;
-            if (!jobHas(job, SOLVABLE_PROVIDES, id))
+            if (seen.insert(SOLVER_SOLVABLE_PROVIDES, id))
                 queue_push2(job, SOLVER_SOLVABLE_PROVIDES, id);
             dataiterator_free(&di);
             break;
@@ -468,6 +478,7 @@ sltrToJob(const HySelector sltr, Queue *job, int solver_action)
         || sltr->getFilterFile() || sltr->getPkgs();
 
     IdQueue job_sltr;
+    JobSeen job_seen;
 
     if (!any_req_filter) {
         if (any_opt_filter) {
@@ -483,13 +494,13 @@ sltrToJob(const HySelector sltr, Queue *job, int solver_action)
     ret = filterPkgToJob(sltr->getPkgs(), job_sltr.getQueue());
     if (ret)
         goto finish;
-    ret = filterNameToJob(sack, sltr->getFilterName(), job_sltr.getQueue());
+    ret = filterNameToJob(sack, sltr->getFilterName(), job_sltr.getQueue(), job_seen);
     if (ret)
         goto finish;
     ret = filterFileToJob(sack, sltr->getFilterFile(), job_sltr.getQueue());
     if (ret)
         goto finish;
-    ret = filterProvidesToJob(sack, sltr->getFilterProvides(), job_sltr.getQueue());
+    ret = filterProvidesToJob(sack, sltr->getFilterProvides(), job_sltr.getQueue(), job_seen);
     if (ret)
         goto finish;
     ret = filterArchToJob(sack, sltr->getFilterArch(), job_sltr.getQueue());
@@ -516,6 +527,7 @@ sltrToJob(const HySelector sltr, Queue *job, int solver_action)
 struct InstallonliesSortCallback {
     Pool *pool;
     Id running_kernel;
+    const std::vector<int> & evrRanks;
 };
 
 static inline void
@@ -553,6 +565,7 @@ sort_packages(const void *ap, const void *bp, void *s_cb)
     Id b = *(Id*)bp;
     Pool *pool = ((struct InstallonliesSortCallback*) s_cb)->pool;
     Id kernel = ((struct InstallonliesSortCallback*) s_cb)->running_kernel;
+    auto & evrRanks = ((struct InstallonliesSortCallback*) s_cb)->evrRanks;
     Solvable *sa = pool_id2solvable(pool, a);
     Solvable *sb = pool_id2solvable(pool, b);
 
@@ -585,7 +598,7 @@ sort_packages(const void *ap, const void *bp, void *s_cb)
             return -1;
         }
     }
-    return pool_evrcmp(pool, sa->evr, sb->evr, EVRCMP_COMPARE);
+    return dnf_sack_evr_rank_cmp(pool, evrRanks, sa->evr, sb->evr);
 }
 
 static void
@@ -832,46 +845,85 @@ Goal::exclude_from_weak_autodetect()
     if (installed_query.empty()) {
         return;
     }
+    Pool * pool = dnf_sack_get_pool(pImpl->sack);
     Query base_query(pImpl->sack);
     base_query.apply();
     auto * installed_pset = installed_query.getResultPset();
+    // Split the considered packages into installed ones and available not installed ones once,
+    // every recommend is then resolved only against these two maps
+    PackageSet installed_considered(*base_query.getResultPset());
+    installed_considered /= *installed_pset;
+    PackageSet available_not_installed(*base_query.getResultPset());
+    available_not_installed -= *installed_pset;
     Id installed_id = -1;
 
     std::vector<const char *> installed_names;
     installed_names.reserve(installed_pset->size() + 1);
 
-    // Iterate over installed packages to detect unmet weak deps
+    // Gather names of non-rich recommends of all installed packages. There can be installed
+    // provider in different version or upgraded packed can recommend a different version,
+    // therefore ignore version and search only by reldep name.
+    IdQueue recommends;
+    IdQueue recommend_names;
+    Map seen_names;
+    map_init(&seen_names, pool->ss.nstrings);
     while ((installed_id = installed_pset->next(installed_id)) != -1) {
-        g_autoptr(DnfPackage) pkg = dnf_package_new(pImpl->sack, installed_id);
-        installed_names.push_back(dnf_package_get_name(pkg));
-        std::unique_ptr<libdnf::DependencyContainer> recommends(dnf_package_get_recommends(pkg));
-        for (int i = 0; i < recommends->count(); ++i) {
-            std::unique_ptr<libdnf::Dependency> dep(recommends->getPtr(i));
-            const char * dep_string = dep->toString();
-            if (dep_string[0] == '(') {
+        Solvable * s = pool_id2solvable(pool, installed_id);
+        installed_names.push_back(pool_id2str(pool, s->name));
+        recommends.clear();
+        solvable_lookup_deparray(s, SOLVABLE_RECOMMENDS, recommends.getQueue(), -1);
+        for (int i = 0; i < recommends.size(); ++i) {
+            Id dep = recommends[i];
+            if (pool_dep2str(pool, dep)[0] == '(') {
                 continue;
             }
-            Query query(base_query);
-            const char * version = dep->getVersion();
-            //  There can be installed provider in different version or upgraded packed can recommend a different version
-            //  Ignore version and search only by reldep name
-            if (version && strlen(version) > 0) {
-                query.addFilter(HY_PKG_PROVIDES, HY_EQ, dep->getName());
-            } else {
-                query.addFilter(HY_PKG_PROVIDES, dep.get());
+            if (ISRELDEP(dep) && pool_id2evr(pool, dep)[0] != '\0') {
+                while (ISRELDEP(dep)) {
+                    dep = GETRELDEP(pool, dep)->name;
+                }
             }
-            // No providers of recommend => continue
-            if (query.empty()) {
-                continue;
+            if (!ISRELDEP(dep)) {
+                if (dep >= seen_names.size << 3) {
+                    map_grow(&seen_names, dep + 1);
+                }
+                if (MAPTST(&seen_names, dep)) {
+                    continue;
+                }
+                MAPSET(&seen_names, dep);
             }
-            Query test_installed(query);
-            test_installed.installed();
-            // when there is not installed any provider of recommend, exclude it
-            if (test_installed.empty()) {
-                add_exclude_from_weak(*query.getResultPset());
+            recommend_names.pushBack(dep);
+        }
+    }
+    map_free(&seen_names);
+
+    // When there is not installed any provider of recommend, exclude all its available providers
+    dnf_sack_make_provides_ready(pImpl->sack);
+    Map * installed_map = installed_considered.getMap();
+    Map * available_map = available_not_installed.getMap();
+    DnfPackageSet exclude(pImpl->sack);
+    Map * exclude_map = exclude.getMap();
+    IdQueue providers;
+    for (int i = 0; i < recommend_names.size(); ++i) {
+        providers.clear();
+        bool provider_installed = false;
+        Id p, pp;
+        FOR_PROVIDES(p, pp, recommend_names[i]) {
+            if (MAPTST(installed_map, p)) {
+                provider_installed = true;
+                break;
+            }
+            if (MAPTST(available_map, p)) {
+                providers.pushBack(p);
             }
         }
+        if (provider_installed) {
+            continue;
+        }
+        for (int j = 0; j < providers.size(); ++j) {
+            MAPSET(exclude_map, providers[j]);
+        }
     }
+    add_exclude_from_weak(exclude);
 
     // Investigate supplements of only available packages with a different name to installed packages
     installed_names.push_back(nullptr);
@@ -1047,36 +1099,25 @@ Goal::listBrokenDependencyPkgs(DnfPackageState pkg_type)
 std::vector<std::vector<std::string>> Goal::describeAllProblemRules(bool pkgs)
 {
     std::vector<std::vector<std::string>> output;
+    // Problems with the same set of rules are reported once, the key is the sorted set of rules
+    std::unordered_set<std::string> seenProblems;
+    ProblemRuleStrCache ruleStrCache;
+    std::unique_ptr<libdnf::PackageSet> modularExcludes(dnf_sack_get_module_excludes(pImpl->sack));
     int count_problems = countProblems();
     for (int i = 0; i < count_problems; i++) {
-        auto problemList = describeProblemRules(i, pkgs);
+        auto problemList = pImpl->describeProblemRules(i, pkgs, modularExcludes.get(), ruleStrCache);
         if (problemList.empty()) {
             continue;
         }
-        bool unique = true;
-        for (auto & problemsSaved: output) {
-            if (problemList.size() != problemsSaved.size()) {
-                continue;
-            }
-            bool presentElement = false;
-            for (auto & problem: problemList) {
-                presentElement = false;
-                for (auto & problemSaved: problemsSaved) {
-                    if (problemSaved == problem) {
-                        presentElement = true;
-                        break;
-                    }
-                }
-                if (!presentElement) {
-                    break;
-                }
-            }
-            if (presentElement) {
-                unique = false;
-            }
+        std::vector<std::string> sortedList(problemList);
+        std::sort(sortedList.begin(), sortedList.end());
+        std::string key;
+        for (auto & problem: sortedList) {
+            key.append(problem);
+            key.push_back('\0');
         }
-        if (unique) {
-            output.push_back(problemList);
+        if (seenProblems.insert(std::move(key)).second) {
+            output.push_back(std::move(problemList));
         }
     }
     return output;
@@ -1084,32 +1125,39 @@ std::vector<std::vector<std::string>> Goal::describeAllProblemRules(bool pkgs)
 
 std::vector<std::string>
 Goal::describeProblemRules(unsigned i, bool pkgs)
+{
+    ProblemRuleStrCache ruleStrCache;
+    std::unique_ptr<libdnf::PackageSet> modularExcludes(dnf_sack_get_module_excludes(pImpl->sack));
+    return pImpl->describeProblemRules(i, pkgs, modularExcludes.get(), ruleStrCache);
+}
+
+std::vector<std::string>
+Goal::Impl::describeProblemRules(unsigned i, bool pkgs, PackageSet * modularExcludes,
+    ProblemRuleStrCache & ruleStrCache)
 {
     std::vector<std::string> output;
     /* internal error */
-    if (i >= (unsigned) pImpl->countProblems())
+    if (i >= (unsigned) countProblems())
         return output;
     // problem is not in libsolv - removal of protected packages
-    auto problem = pImpl->describeProtectedRemoval();
+    auto problem = describeProtectedRemoval();
     if (!problem.empty()) {
         output.push_back(std::move(problem));
         return output;
     }
-    auto solv = pImpl->solv;
 
     Id rid, source, target, dep;
     SolverRuleinfo type;
     int j;
-    bool unique;
 
     if (i >= solver_problem_count(solv))
         return output;
 
     IdQueue pq;
     IdQueue rq;
+    std::unordered_set<std::string> seen;
     // this libsolv interface indexes from 1 (we do from 0), so:
     solver_findallproblemrules(solv, i+1, pq.getQueue());
-    std::unique_ptr<libdnf::PackageSet> modularExcludes(dnf_sack_get_module_excludes(pImpl->sack));
     for (j = 0; j < pq.size(); j++) {
         rid = pq[j];
         if (solver_allruleinfos(solv, rid, rq.getQueue())) {
@@ -1118,17 +1166,14 @@ Goal::describeProblemRules(unsigned i, bool pkgs)
                 source = rq[ir + 1];
                 target = rq[ir + 2];
                 dep = rq[ir + 3];
-                auto problem_str = libdnf_problemruleinfo2str(modularExcludes.get(), solv, type,
-                                                              source, target, dep, pkgs);
-                unique = true;
-                for (auto & item: output) {
-                    if (problem_str == item) {
-                        unique = false;
-                        break;
-                    }
+                auto ruleKey = std::make_tuple(static_cast<int>(type), source, target, dep);
+                auto cached = ruleStrCache.find(ruleKey);
+                if (cached == ruleStrCache.end()) {
+                    cached = ruleStrCache.emplace(ruleKey, libdnf_problemruleinfo2str(
+                        modularExcludes, solv, type, source, target, dep, pkgs)).first;
                 }
-                if (unique) {
-                    output.push_back(problem_str);
+                if (seen.insert(cached->second).second) {
+                    output.push_back(cached->second);
                 }
             }
         }
@@ -1183,9 +1228,18 @@ Goal::writeDebugdata(const char *dir)
     }
 }
 
-PackageSet
-Goal::Impl::listResults(Id type_filter1, Id type_filter2)
+Goal::ClassifiedResults::ClassifiedResults(DnfSack * sack)
+: installs(sack), erasures(sack), upgrades(sack), downgrades(sack), reinstalls(sack)
+, obsoleted(sack)
+{}
+
+const Goal::ClassifiedResults &
+Goal::Impl::classifyResults()
 {
+    if (results) {
+        return *results;
+    }
+
     /* no transaction */
     if (!trans) {
         if (!solv) {
@@ -1197,53 +1251,73 @@ Goal::Impl::listResults(Id type_filter1, Id type_filter2)
         throw Goal::Error(_("no solution possible"), DNF_ERROR_NO_SOLUTION);
     }
 
-    PackageSet plist(sack);
+    std::unique_ptr<ClassifiedResults> classified(new ClassifiedResults(sack));
     const int common_mode = SOLVER_TRANSACTION_SHOW_OBSOLETES |
         SOLVER_TRANSACTION_CHANGE_IS_REINSTALL;
 
     for (int i = 0; i < trans->steps.count; ++i) {
         Id p = trans->steps.elements[i];
-        Id type;
-
-        switch (type_filter1) {
-        case SOLVER_TRANSACTION_OBSOLETED:
-            type =  transaction_type(trans, p, common_mode);
+        Id type  = transaction_type(trans, p, common_mode |
+                                    SOLVER_TRANSACTION_SHOW_ACTIVE|
+                                    SOLVER_TRANSACTION_SHOW_ALL);
+
+        switch (type) {
+        case SOLVER_TRANSACTION_INSTALL:
+        case SOLVER_TRANSACTION_OBSOLETES:
+            classified->installs.set(p);
+            break;
+        case SOLVER_TRANSACTION_ERASE:
+            classified->erasures.set(p);
+            break;
+        case SOLVER_TRANSACTION_UPGRADE:
+            classified->upgrades.set(p);
+            break;
+        case SOLVER_TRANSACTION_DOWNGRADE:
+            classified->downgrades.set(p);
+            break;
+        case SOLVER_TRANSACTION_REINSTALL:
+            classified->reinstalls.set(p);
             break;
         default:
-            type  = transaction_type(trans, p, common_mode |
-                                     SOLVER_TRANSACTION_SHOW_ACTIVE|
-                                     SOLVER_TRANSACTION_SHOW_ALL);
             break;
         }
 
-        if (type == type_filter1 || (type_filter2 && type == type_filter2))
-            plist.set(p);
+        // obsoleted packages are reported only by the passive view of the step
+        if (transaction_type(trans, p, common_mode) == SOLVER_TRANSACTION_OBSOLETED)
+            classified->obsoleted.set(p);
     }
-    return plist;
+    results = std::move(classified);
+    return *results;
+}
+
+const Goal::ClassifiedResults &
+Goal::classifyResults()
+{
+    return pImpl->classifyResults();
 }
 
 PackageSet
 Goal::listErasures()
 {
-    return pImpl->listResults(SOLVER_TRANSACTION_ERASE, 0);
+    return pImpl->classifyResults().erasures;
 }
 
 PackageSet
 Goal::listInstalls()
 {
-    return pImpl->listResults(SOLVER_TRANSACTION_INSTALL, SOLVER_TRANSACTION_OBSOLETES);
+    return pImpl->classifyResults().installs;
 }
 
 PackageSet
 Goal::listObsoleted()
 {
-    return pImpl->listResults(SOLVER_TRANSACTION_OBSOLETED, 0);
+    return pImpl->classifyResults().obsoleted;
 }
 
 PackageSet
 Goal::listReinstalls()
 {
-    return pImpl->listResults(SOLVER_TRANSACTION_REINSTALL, 0);
+    return pImpl->classifyResults().reinstalls;
 }
 
 PackageSet
@@ -1273,13 +1347,13 @@ Goal::listSuggested()
 PackageSet
 Goal::listUpgrades()
 {
-    return pImpl->listResults(SOLVER_TRANSACTION_UPGRADE, 0);
+    return pImpl->classifyResults().upgrades;
 }
 
 PackageSet
 Goal::listDowngrades()
 {
-    return pImpl->listResults(SOLVER_TRANSACTION_DOWNGRADE, 0);
+    return pImpl->classifyResults().downgrades;
 }
 
 PackageSet
@@ -1455,7 +1529,8 @@ Goal::Impl::limitInstallonlyPackages(Solver *solv, Queue *job)
             continue;
         }
 
-        struct InstallonliesSortCallback s_cb = {pool, dnf_sack_running_kernel(sack)};
+        struct InstallonliesSortCallback s_cb = {
+            pool, dnf_sack_running_kernel(sack), dnf_sack_get_evr_ranks(sack)};
         solv_sort(q.data(), q.size(), sizeof(q[0]), sort_packages, &s_cb);
         IdQueue same_names;
         while (q.size() > 0) {
@@ -1486,6 +1561,7 @@ Goal::Impl::solve(Queue *job, DnfGoalActions flags)
         transaction_free(trans);
         trans = NULL;
     }
+    results.reset();
 
     Solver *solv = initSolver();
 
@@ -1630,9 +1706,9 @@ Goal::Impl::protectedInRemovals()
     bool ret = false;
     if ((!protectedPkgs || !protectedPkgs->size()) && !protect_running_kernel)
         return false;
-    auto pkgRemoveList = listResults(SOLVER_TRANSACTION_ERASE, 0);
-    auto pkgObsoleteList = listResults(SOLVER_TRANSACTION_OBSOLETED, 0);
-    map_or(pkgRemoveList.getMap(), pkgObsoleteList.getMap());
+    auto & classified = classifyResults();
+    PackageSet pkgRemoveList(classified.erasures);
+    map_or(pkgRemoveList.getMap(), classified.obsoleted.getMap());
 
     removalOfProtected.reset(new PackageSet(pkgRemoveList));
     Id id = -1;
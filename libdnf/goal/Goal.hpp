@@ -29,6 +29,7 @@
 #include "../error.hpp"
 #include "../hy-goal.h"
 #include "../hy-package.h"
+#include "../sack/packageset.hpp"
 
 namespace libdnf {
 
@@ -42,6 +43,17 @@ public:
         int errCode;
     };
 
+    /// Packages of the resolved transaction sorted by the kind of change
+    struct ClassifiedResults {
+        explicit ClassifiedResults(DnfSack * sack);
+        PackageSet installs;
+        PackageSet erasures;
+        PackageSet upgrades;
+        PackageSet downgrades;
+        PackageSet reinstalls;
+        PackageSet obsoleted;
+    };
+
     Goal(DnfSack *sack);
     Goal(const Goal & goal_src);
     Goal(Goal && goal_src) = delete;
@@ -137,6 +149,13 @@ public:
     void writeDebugdata(const char *dir);
 
     /* result processing */
+
+    /**
+    * @brief Walks the transaction once and sorts its packages by the kind of change. The result is
+    * cached until the goal is solved again, list functions for the same kinds are served from it.
+    * If there is no transaction, it rises Goal::Error.
+    */
+    const ClassifiedResults & classifyResults();
     PackageSet listErasures();
     PackageSet listInstalls();
     PackageSet listObsoleted();
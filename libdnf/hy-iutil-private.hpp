@@ -53,6 +53,7 @@ int solv_userdata_verify(const SolvUserdata *solv_userdata, const unsigned char
 int checksum_cmp(const unsigned char *cs1, const unsigned char *cs2);
 int checksum_fp(unsigned char *out, FILE *fp);
 int checksum_stat(unsigned char *out, FILE *fp);
+int checksum_rpmdb(unsigned char *out, const char *rootdir);
 int checksumt_l2h(int type);
 const char *pool_checksum_str(Pool *pool, const unsigned char *chksum);
 
@@ -77,8 +78,8 @@ Id running_kernel(DnfSack *sack);
 Repo *repo_by_name(DnfSack *sack, const char *name);
 HyRepo hrepo_by_name(DnfSack *sack, const char *name);
 Id str2archid(Pool *pool, const char *s);
-Id what_upgrades(Pool *pool, Id p);
-Id what_downgrades(Pool *pool, Id p);
+Id what_upgrades(DnfSack *sack, Id p);
+Id what_downgrades(DnfSack *sack, Id p);
 Map *free_map_fully(Map *m);
 int is_package(const Pool *pool, const Solvable *s);
 
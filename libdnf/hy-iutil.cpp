@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/utsname.h>
@@ -67,9 +68,16 @@ extern "C" {
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
 
 #define BUF_BLOCK 4096
+#define CHKSUM_READ_BLOCK (1024 * 1024)
+#define CHKSUM_ADD_MAX (64 * 1024 * 1024)
 #define CHKSUM_TYPE REPOKEY_TYPE_SHA256
 #define CHKSUM_IDENT "H000"
 #define CACHEDIR_PERMISSIONS 0700
@@ -124,21 +132,85 @@ checksum_cmp(const unsigned char *cs1, const unsigned char *cs2)
     return memcmp(cs1, cs2, CHKSUM_BYTES);
 }
 
+typedef std::tuple<dev_t, ino_t, off_t, long long> ChecksumFileKey;
+
+/* file checksums are remembered for the lifetime of the process, the same
+ * repomd.xml is typically hashed several times during a single setup */
+static std::mutex checksum_cache_mutex;
+static std::map<ChecksumFileKey, std::array<unsigned char, CHKSUM_BYTES>> checksum_cache;
+
+static void
+checksum_add_data(Chksum *h, const char *data, size_t len)
+{
+    // solv_chksum_add() takes an int length
+    while (len > 0) {
+        size_t chunk = len < CHKSUM_ADD_MAX ? len : CHKSUM_ADD_MAX;
+        solv_chksum_add(h, data, chunk);
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+/* hashes the whole content of fp, mapped into memory when possible */
+static void
+checksum_add_content(Chksum *h, FILE *fp, const struct stat *st)
+{
+    int fd = fileno(fp);
+    if (st != NULL && st->st_size > 0) {
+        size_t len = st->st_size;
+        void *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, len, MADV_SEQUENTIAL);
+            checksum_add_data(h, static_cast<const char *>(data), len);
+            munmap(data, len);
+            return;
+        }
+    }
+
+    /* pipes, memory streams and filesystems without mmap support */
+    if (fd >= 0)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    std::unique_ptr<char[]> buf(new char[CHKSUM_READ_BLOCK]);
+    size_t l;
+    while ((l = fread(buf.get(), 1, CHKSUM_READ_BLOCK, fp)) > 0)
+        solv_chksum_add(h, buf.get(), l);
+}
+
 /* calls rewind(fp) before returning */
 int
 checksum_fp(unsigned char *out, FILE *fp)
 {
     /* based on calc_checksum_fp in libsolv's solv.c */
-    char buf[4096];
-    auto h = solv_chksum_create(CHKSUM_TYPE);
-    int l;
+    struct stat st;
+    ChecksumFileKey key;
 
+    /* also flushes pending writes, so that the descriptor sees them */
     rewind(fp);
+    int fd = fileno(fp);
+    bool regular = fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (regular) {
+        key = ChecksumFileKey(st.st_dev, st.st_ino, st.st_size,
+                              st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec);
+        std::lock_guard<std::mutex> guard(checksum_cache_mutex);
+        auto it = checksum_cache.find(key);
+        if (it != checksum_cache.end()) {
+            memcpy(out, it->second.data(), CHKSUM_BYTES);
+            return 0;
+        }
+    }
+
+    auto h = solv_chksum_create(CHKSUM_TYPE);
     solv_chksum_add(h, CHKSUM_IDENT, strlen(CHKSUM_IDENT));
-    while ((l = fread(buf, 1, sizeof(buf), fp)) > 0)
-        solv_chksum_add(h, buf, l);
+    checksum_add_content(h, fp, regular ? &st : NULL);
     rewind(fp);
     solv_chksum_free(h, out);
+
+    if (regular) {
+        std::array<unsigned char, CHKSUM_BYTES> checksum;
+        memcpy(checksum.data(), out, CHKSUM_BYTES);
+        std::lock_guard<std::mutex> guard(checksum_cache_mutex);
+        checksum_cache[key] = checksum;
+    }
     return 0;
 }
 
@@ -163,6 +235,43 @@ checksum_stat(unsigned char *out, FILE *fp)
     return 0;
 }
 
+/* checksum of stat data of all rpmdb files, it changes with every write to the rpmdb */
+int
+checksum_rpmdb(unsigned char *out, const char *rootdir)
+{
+    static const char * const dbpaths[] = {"/usr/lib/sysimage/rpm", "/var/lib/rpm"};
+    auto h = solv_chksum_create(CHKSUM_TYPE);
+    int found = 0;
+
+    solv_chksum_add(h, CHKSUM_IDENT, strlen(CHKSUM_IDENT));
+    for (auto dbpath : dbpaths) {
+        g_autofree gchar *path = g_build_filename(rootdir ? rootdir : "/", dbpath, NULL);
+        struct dirent **entries;
+        int nentries = scandir(path, &entries, NULL, alphasort);
+        if (nentries < 0)
+            continue;
+        for (int i = 0; i < nentries; ++i) {
+            const char *name = entries[i]->d_name;
+            g_autofree gchar *fn = g_build_filename(path, name, NULL);
+            struct stat st;
+            // lock files and sqlite shared memory are touched by readers too
+            bool volatile_file = name[0] == '.' || g_str_has_suffix(name, "-shm");
+            if (!volatile_file && lstat(fn, &st) == 0 && S_ISREG(st.st_mode)) {
+                solv_chksum_add(h, name, strlen(name));
+                solv_chksum_add(h, &st.st_dev, sizeof(st.st_dev));
+                solv_chksum_add(h, &st.st_ino, sizeof(st.st_ino));
+                solv_chksum_add(h, &st.st_size, sizeof(st.st_size));
+                solv_chksum_add(h, &st.st_mtim, sizeof(st.st_mtim));
+                ++found;
+            }
+            free(entries[i]);
+        }
+        free(entries);
+    }
+    solv_chksum_free(h, out);
+    return found ? 0 : 1;
+}
+
 static std::array<char, solv_userdata_solv_toolversion_size>
 get_padded_solv_toolversion()
 {
@@ -633,6 +742,23 @@ str2archid(Pool *pool, const char *arch)
     return id;
 }
 
+/**
+ * Return the installed package with the highest version in the EVR sorted list, for equal
+ * versions the one with the lowest Id.
+ */
+static Id
+highest_installed(Pool *pool, const std::vector<Id> *installed)
+{
+    if (!installed || installed->empty())
+        return 0;
+    auto it = installed->end() - 1;
+    Id evr = pool_id2solvable(pool, *it)->evr;
+    while (it != installed->begin() &&
+           pool_evrcmp(pool, pool_id2solvable(pool, *(it - 1))->evr, evr, EVRCMP_COMPARE) == 0)
+        --it;
+    return *it;
+}
+
 /**
  * Return id of a package that can be upgraded with pkg.
  *
@@ -654,32 +780,33 @@ str2archid(Pool *pool, const char *arch)
  * Or 0 if none such package is installed.
  */
 Id
-what_upgrades(Pool *pool, Id pkg)
+what_upgrades(DnfSack *sack, Id pkg)
 {
-    Id l = 0, l_evr = 0;
-    Id p, pp;
-    Solvable *updated, *s = pool_id2solvable(pool, pkg);
+    Pool *pool = dnf_sack_get_pool(sack);
+    Solvable *s = pool_id2solvable(pool, pkg);
+    Id l;
 
     assert(pool->installed);
-    assert(pool->whatprovides);
-    FOR_PROVIDES(p, pp, s->name) {
-        updated = pool_id2solvable(pool, p);
-        if (updated->repo != pool->installed ||
-            updated->name != s->name)
-            continue;
-        if (updated->arch != s->arch &&
-            updated->arch != ARCH_NOARCH &&
-            s->arch != ARCH_NOARCH)
-            continue;
-        if (pool_evrcmp(pool, updated->evr, s->evr, EVRCMP_COMPARE) >= 0)
-            // >= version installed, this pkg can not be used for upgrade
-            return 0;
-        if (l == 0 ||
-            pool_evrcmp(pool, updated->evr, l_evr, EVRCMP_COMPARE) > 0) {
-            l = p;
-            l_evr = updated->evr;
+    if (s->arch == ARCH_NOARCH) {
+        l = highest_installed(pool, dnf_sack_get_installed_by_name(sack, s->name, 0));
+    } else {
+        l = highest_installed(pool, dnf_sack_get_installed_by_name(sack, s->name, s->arch));
+        Id l_noarch = highest_installed(
+            pool, dnf_sack_get_installed_by_name(sack, s->name, ARCH_NOARCH));
+        if (l == 0) {
+            l = l_noarch;
+        } else if (l_noarch != 0) {
+            int cmp = pool_evrcmp(pool, pool_id2solvable(pool, l_noarch)->evr,
+                                  pool_id2solvable(pool, l)->evr, EVRCMP_COMPARE);
+            if (cmp > 0 || (cmp == 0 && l_noarch < l))
+                l = l_noarch;
         }
     }
+    if (l == 0)
+        return 0;
+    if (pool_evrcmp(pool, pool_id2solvable(pool, l)->evr, s->evr, EVRCMP_COMPARE) >= 0)
+        // >= version installed, this pkg can not be used for upgrade
+        return 0;
     return l;
 }
 
@@ -697,29 +824,20 @@ what_upgrades(Pool *pool, Id pkg)
  * Or 0 if none such package is installed.
  */
 Id
-what_downgrades(Pool *pool, Id pkg)
+what_downgrades(DnfSack *sack, Id pkg)
 {
-    Id l = 0, l_evr = 0;
-    Id p, pp;
-    Solvable *updated, *s = pool_id2solvable(pool, pkg);
+    Pool *pool = dnf_sack_get_pool(sack);
+    Solvable *s = pool_id2solvable(pool, pkg);
 
     assert(pool->installed);
-    assert(pool->whatprovides);
-    FOR_PROVIDES(p, pp, s->name) {
-        updated = pool_id2solvable(pool, p);
-        if (updated->repo != pool->installed ||
-            updated->name != s->name ||
-            updated->arch != s->arch)
-            continue;
-        if (pool_evrcmp(pool, updated->evr, s->evr, EVRCMP_COMPARE) <= 0)
-            // <= version installed, this pkg can not be used for downgrade
-            return 0;
-        if (l == 0 ||
-            pool_evrcmp(pool, updated->evr, l_evr, EVRCMP_COMPARE) < 0) {
-            l = p;
-            l_evr = updated->evr;
-        }
-    }
+    auto installed = dnf_sack_get_installed_by_name(sack, s->name, s->arch);
+    if (!installed || installed->empty())
+        return 0;
+    // the list is sorted by EVR and Id, the first one is the lowest version with the lowest Id
+    Id l = installed->front();
+    if (pool_evrcmp(pool, pool_id2solvable(pool, l)->evr, s->evr, EVRCMP_COMPARE) <= 0)
+        // <= version installed, this pkg can not be used for downgrade
+        return 0;
     return l;
 }
 
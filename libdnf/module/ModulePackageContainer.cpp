@@ -19,11 +19,16 @@
  */
 
 #include <algorithm>
+#include <fnmatch.h>
+#include <future>
 #include <set>
 #include <sstream>
+#include <unordered_map>
 
 extern "C" {
 #include <solv/poolarch.h>
+#include <solv/repo_solv.h>
+#include <solv/repo_write.h>
 #include <solv/solver.h>
 }
 
@@ -33,7 +38,9 @@ extern "C" {
 #include "libdnf/utils/File.hpp"
 #include "libdnf/dnf-sack-private.hpp"
 #include "libdnf/hy-query.h"
+#include "libdnf/hy-query-private.hpp"
 #include "libdnf/hy-types.h"
+#include "libdnf/hy-util-private.hpp"
 #include <functional>
 #include <../sack/query.hpp>
 #include "../log.hpp"
@@ -69,6 +76,125 @@ void goal2name_query(libdnf::Goal & goal, libdnf::Query & query)
     query.addFilter(HY_PKG_NAME, HY_EQ, module_names.data());
 }
 
+/**
+ * @brief Copy repositories of the module sack into a new sack. libsolv pools are not thread safe,
+ * every concurrently solved goal needs its own. Packages not considered in the source sack are
+ * excluded in the copy.
+ */
+DnfSack * cloneModuleSack(DnfSack * moduleSack)
+{
+    Pool * pool = dnf_sack_get_pool(moduleSack);
+    DnfSack * clone = dnf_sack_new();
+    if (dnf_sack_get_all_arch(moduleSack)) {
+        dnf_sack_set_all_arch(clone, TRUE);
+    } else {
+        dnf_sack_set_arch(clone, dnf_sack_get_arch(moduleSack), NULL);
+    }
+    dnf_sack_set_allow_vendor_change(clone, dnf_sack_get_allow_vendor_change(moduleSack));
+    Pool * clonePool = dnf_sack_get_pool(clone);
+
+    std::vector<Id> notConsidered;
+    libdnf::LibsolvRepo * repo;
+    Id repoId;
+    FOR_REPOS(repoId, repo) {
+        char * buffer = nullptr;
+        size_t size = 0;
+        FILE * fp = open_memstream(&buffer, &size);
+        repo_write(repo, fp);
+        fclose(fp);
+
+        HyRepo hrepo = hy_repo_create(repo->name);
+        auto repoImpl = libdnf::repoGetImpl(hrepo);
+        libdnf::LibsolvRepo * cloneRepo = repo_create(clonePool, repo->name);
+        cloneRepo->appdata = hrepo;
+        cloneRepo->priority = repo->priority;
+        cloneRepo->subpriority = repo->subpriority;
+        repoImpl->libsolvRepo = cloneRepo;
+        fp = fmemopen(buffer, size, "r");
+        repo_add_solv(cloneRepo, fp, 0);
+        fclose(fp);
+        free(buffer);
+        if (repo == pool->installed) {
+            pool_set_installed(clonePool, cloneRepo);
+        }
+
+        if (!pool->considered) {
+            continue;
+        }
+        // Solvables are written and read in the repo order, pair them to transfer excludes
+        std::vector<Id> sourceIds;
+        Id p;
+        Solvable * s;
+        FOR_REPO_SOLVABLES(repo, p, s) {
+            sourceIds.push_back(p);
+        }
+        auto sourceIter = sourceIds.begin();
+        FOR_REPO_SOLVABLES(cloneRepo, p, s) {
+            if (sourceIter == sourceIds.end()) {
+                break;
+            }
+            if (!MAPTST(pool->considered, *sourceIter)) {
+                notConsidered.push_back(p);
+            }
+            ++sourceIter;
+        }
+    }
+
+    libdnf::PackageSet excludes(clone);
+    for (auto id : notConsidered) {
+        excludes.set(id);
+    }
+    dnf_sack_add_excludes(clone, &excludes);
+    return clone;
+}
+
+struct ModuleSolveAttempt {
+    bool solved{false};
+    std::vector<std::vector<std::string>> problems;
+    std::vector<std::string> installNames;
+    std::vector<std::string> conflictNevras;
+};
+
+/**
+ * @brief Solve installation of module provides on a sack used exclusively by the calling thread
+ *
+ * @param provides pairs of "module(<name>:<stream>)" and whether the install is optional
+ * @param listConflicts whether to list available conflicting packages when the goal fails
+ */
+ModuleSolveAttempt solveModuleAttempt(DnfSack * sack,
+    const std::vector<std::pair<std::string, bool>> & provides, DnfGoalActions flags,
+    bool describeProblems, bool listConflicts)
+{
+    ModuleSolveAttempt attempt;
+    libdnf::Goal goal(sack);
+    for (const auto & provide : provides) {
+        libdnf::Selector selector(sack);
+        selector.set(HY_PKG_PROVIDES, HY_EQ, provide.first.c_str());
+        goal.install(&selector, provide.second);
+    }
+    auto pool = dnf_sack_get_pool(sack);
+    if (goal.run(flags)) {
+        if (describeProblems) {
+            attempt.problems = goal.describeAllProblemRules(false);
+        }
+        if (listConflicts) {
+            auto conflictList = goal.listConflictPkgs(DNF_PACKAGE_STATE_AVAILABLE);
+            Id id = -1;
+            while ((id = conflictList->next(id)) != -1) {
+                attempt.conflictNevras.emplace_back(pool_solvable2str(pool, pool_id2solvable(pool, id)));
+            }
+        }
+        return attempt;
+    }
+    attempt.solved = true;
+    auto installList = goal.listInstalls();
+    Id id = -1;
+    while ((id = installList.next(id)) != -1) {
+        attempt.installNames.emplace_back(pool_id2str(pool, pool_id2solvable(pool, id)->name));
+    }
+    return attempt;
+}
+
 /**
  * @brief In python => ";".join(list.sort())
  */
@@ -95,6 +221,11 @@ struct default_delete<DIR> {
     void operator()(DIR * ptr) noexcept { closedir(ptr); }
 };
 
+template<>
+struct default_delete<DnfSack> {
+    void operator()(DnfSack * ptr) noexcept { g_object_unref(ptr); }
+};
+
 }
 
 namespace libdnf {
@@ -187,10 +318,19 @@ public:
     ~Impl();
     std::pair<std::vector<std::vector<std::string>>, ModulePackageContainer::ModuleErrorType> moduleSolve(
         const std::vector<ModulePackage *> & modules, bool debugSolver);
+    bool moduleSolveParallel(const std::vector<ModulePackage *> & modules,
+        std::vector<std::vector<std::string>> & problems,
+        ModulePackageContainer::ModuleErrorType & problemType,
+        std::unique_ptr<PackageSet> & conflictingPkgs);
     bool insert(const std::string &moduleName, const char *path);
     std::vector<ModulePackage *> getLatestActiveEnabledModules();
     /// Required to call after all modules v3 are in metadata
     void addVersion2Modules();
+    /// Adds the modules from parsed metadata to the repo with given ID
+    void addModules(ModuleMetadata & md, const std::string & repoID);
+    /// Exact name and stream lookup, context, version and arch can be globs or empty
+    std::vector<ModulePackage *> queryIndex(const std::string & name, const std::string & stream,
+        const std::string & version, const std::string & context, const std::string & arch);
 
 private:
     friend struct ModulePackageContainer;
@@ -207,6 +347,9 @@ private:
     /// solvable.conflicts = module(<moduleName>)
     DnfSack * moduleSack;
     std::unique_ptr<PackageSet> activatedModules;
+    /// Bumped whenever activatedModules are recomputed
+    unsigned long activeGeneration{0};
+    bool parallelSolving{false};
     std::string installRoot;
     std::string persistDir;
     ModuleMetadata moduleMetadata;
@@ -214,6 +357,31 @@ private:
     std::map<std::string, std::string> moduleDefaults;
     std::vector<std::tuple<LibsolvRepo *, ModulemdModuleStream *, std::string>> modulesV2;
 
+    /// Available modules by "name:stream" and by "name:stream:context", ordered by Id.
+    /// Built on first use, dropped whenever modules are added.
+    struct ModuleIndex {
+        std::unordered_map<std::string, std::vector<ModulePackage *>> byNameStream;
+        std::unordered_map<std::string, std::vector<ModulePackage *>> byNameStreamContext;
+    };
+    std::unique_ptr<ModuleIndex> moduleIndex;
+    const ModuleIndex & getModuleIndex();
+
+    /// Artifacts of active modules as Ids of the packages sack, keyed by artifact name.
+    /// Rebuilt when active modules are recomputed or when the packages pool gets new strings.
+    struct ArtifactIndex {
+        struct Artifact {
+            Id evr;
+            Id arch;
+            Id moduleId;
+        };
+        DnfSack * sack;
+        unsigned long generation;
+        int nstrings;
+        std::unordered_map<Id, std::vector<Artifact>> byName;
+    };
+    std::unique_ptr<ArtifactIndex> artifactIndex;
+    const ArtifactIndex & getArtifactIndex(DnfSack * sack);
+
     bool isEnabled(const std::string &name, const std::string &stream);
 };
 
@@ -348,8 +516,7 @@ void ModulePackageContainer::addDefaultsFromDisk()
             pImpl->installRoot.c_str(), "/etc/dnf/modules.defaults.d/", NULL);
 
     for (const auto &file : filesystem::getDirContent(dirPath)) {
-        std::string yamlContent = getFileContent(file);
-        pImpl->moduleMetadata.addMetadataFromString(yamlContent, 1000);
+        pImpl->moduleMetadata.addMetadataFromFile(file, 1000);
     }
 }
 
@@ -362,10 +529,16 @@ void ModulePackageContainer::moduleDefaultsResolve()
 void
 ModulePackageContainer::add(const std::string &fileContent, const std::string & repoID)
 {
-    Pool * pool = dnf_sack_get_pool(pImpl->moduleSack);
-
     ModuleMetadata md;
     md.addMetadataFromString(fileContent, 0);
+    pImpl->addModules(md, repoID);
+}
+
+void
+ModulePackageContainer::Impl::addModules(ModuleMetadata & md, const std::string & repoID)
+{
+    Pool * pool = dnf_sack_get_pool(moduleSack);
+
     md.resolveAddedMetadata();
 
     LibsolvRepo * repo = nullptr;
@@ -381,7 +554,6 @@ ModulePackageContainer::add(const std::string &fileContent, const std::string &
 
     // If not created yet, create it
     if (!repo) {
-        Pool * pool = dnf_sack_get_pool(pImpl->moduleSack);
         HyRepo hrepo = hy_repo_create(repoID.c_str());
         auto repoImpl = libdnf::repoGetImpl(hrepo);
         repo = repo_create(pool, repoID.c_str());
@@ -391,12 +563,13 @@ ModulePackageContainer::add(const std::string &fileContent, const std::string &
     }
 
     // add all modules to repository and pass ownership to module container
-    g_autofree gchar * path = g_build_filename(pImpl->installRoot.c_str(), "/etc/dnf/modules.d", NULL);
-    auto packages = md.getAllModulePackages(pImpl->moduleSack, repo, repoID, pImpl->modulesV2);
+    g_autofree gchar * path = g_build_filename(installRoot.c_str(), "/etc/dnf/modules.d", NULL);
+    auto packages = md.getAllModulePackages(moduleSack, repo, repoID, modulesV2);
+    moduleIndex.reset();
     for(auto const& modulePackagePtr: packages) {
         std::unique_ptr<ModulePackage> modulePackage(modulePackagePtr);
-        pImpl->modules.insert(std::make_pair(modulePackage->getId(), std::move(modulePackage)));
-        pImpl->persistor->insert(modulePackagePtr->getName(), path);
+        modules.insert(std::make_pair(modulePackage->getId(), std::move(modulePackage)));
+        persistor->insert(modulePackagePtr->getName(), path);
     }
 }
 
@@ -446,35 +619,71 @@ ModulePackage * ModulePackageContainer::getModulePackage(Id id)
 std::vector<ModulePackage *>
 ModulePackageContainer::requiresModuleEnablement(const PackageSet & packages)
 {
-    auto activatedModules = pImpl->activatedModules.get();
-    if (!activatedModules) {
+    if (!pImpl->activatedModules) {
         return {};
     }
-    std::vector<ModulePackage *> output;
-    Query baseQuery(packages.getSack());
+    auto sack = packages.getSack();
+    Pool * pool = dnf_sack_get_pool(sack);
+    auto & index = pImpl->getArtifactIndex(sack);
+
+    Query baseQuery(sack);
     baseQuery.addFilter(HY_PKG, HY_EQ, &packages);
-    baseQuery.apply();
-    Query testQuery(baseQuery);
-    Id moduleId = -1;
-    while ((moduleId = activatedModules->next(moduleId)) != -1) {
-        auto module = getModulePackage(moduleId);
-        if (isEnabled(module)) {
+    auto candidates = baseQuery.runSet();
+
+    std::vector<Id> moduleIds;
+    Id id = -1;
+    while ((id = candidates->next(id)) != -1) {
+        Solvable * s = pool_id2solvable(pool, id);
+        auto it = index.byName.find(s->name);
+        if (it == index.byName.end()) {
             continue;
         }
-        auto includeNEVRAs = module->getArtifacts();
-        std::vector<const char *> includeNEVRAsCString(includeNEVRAs.size() + 1);
-        transform(includeNEVRAs.begin(), includeNEVRAs.end(), includeNEVRAsCString.begin(),
-                  std::mem_fn(&std::string::c_str));
-        testQuery.queryUnion(baseQuery);
-        testQuery.addFilter(HY_PKG_NEVRA_STRICT, HY_EQ, includeNEVRAsCString.data());
-        if (testQuery.empty()) {
-            continue;
+        for (auto & artifact : it->second) {
+            if (artifact.evr == s->evr && artifact.arch == s->arch) {
+                moduleIds.push_back(artifact.moduleId);
+            }
+        }
+    }
+    std::sort(moduleIds.begin(), moduleIds.end());
+    moduleIds.erase(std::unique(moduleIds.begin(), moduleIds.end()), moduleIds.end());
+
+    std::vector<ModulePackage *> output;
+    for (auto moduleId : moduleIds) {
+        auto module = getModulePackage(moduleId);
+        if (!isEnabled(module)) {
+            output.push_back(module);
         }
-        output.push_back(module);
     }
     return output;
 }
 
+const ModulePackageContainer::Impl::ArtifactIndex &
+ModulePackageContainer::Impl::getArtifactIndex(DnfSack * sack)
+{
+    Pool * pool = dnf_sack_get_pool(sack);
+    if (artifactIndex && artifactIndex->sack == sack && artifactIndex->generation == activeGeneration
+        && artifactIndex->nstrings == pool->ss.nstrings) {
+        return *artifactIndex;
+    }
+    artifactIndex.reset(new ArtifactIndex);
+    artifactIndex->sack = sack;
+    artifactIndex->generation = activeGeneration;
+    artifactIndex->nstrings = pool->ss.nstrings;
+    if (!activatedModules) {
+        return *artifactIndex;
+    }
+    NevraID nevraId;
+    Id moduleId = -1;
+    while ((moduleId = activatedModules->next(moduleId)) != -1) {
+        for (auto & artifact : modules.at(moduleId)->getArtifacts()) {
+            // same matching as HY_PKG_NEVRA_STRICT, unknown strings cannot match any package
+            if (nevraId.parse(pool, artifact.c_str(), true)) {
+                artifactIndex->byName[nevraId.name].push_back({nevraId.evr, nevraId.arch, moduleId});
+            }
+        }
+    }
+    return *artifactIndex;
+}
 
 /**
  * @brief Is a ModulePackage part of an enabled stream?
@@ -678,6 +887,99 @@ void ModulePackageContainer::uninstall(const ModulePackage * module, const std::
         pImpl->persistor->removeProfile(module->getName(), profile);
 }
 
+/**
+ * @brief Run the strict and the relaxed goals of moduleSolve() concurrently on copies of
+ * the module sack. Returns false when none of them succeeds, problems of the strict goal and
+ * the conflicting packages of the most relaxed one are returned then, the caller has to drop
+ * the conflicting modules.
+ */
+bool
+ModulePackageContainer::Impl::moduleSolveParallel(const std::vector<ModulePackage *> & modules,
+    std::vector<std::vector<std::string>> & problems,
+    ModulePackageContainer::ModuleErrorType & problemType,
+    std::unique_ptr<PackageSet> & conflictingPkgs)
+{
+    std::vector<std::pair<std::string, bool>> provides;
+    for (const auto & module : modules) {
+        std::ostringstream ss;
+        auto name = module->getName();
+        ss << "module(" << name << ":" << module->getStream() << ")";
+        provides.emplace_back(ss.str(), persistor->getState(name) == ModuleState::DEFAULT);
+    }
+
+    // Ordered from the strictest one, the same as in the sequential path
+    const DnfGoalActions attemptFlags[] = {
+        static_cast<DnfGoalActions>(DNF_IGNORE_WEAK | DNF_FORCE_BEST),
+        DNF_FORCE_BEST,
+        DNF_NONE
+    };
+    const ModulePackageContainer::ModuleErrorType attemptErrors[] = {
+        ModulePackageContainer::ModuleErrorType::NO_ERROR,
+        ModulePackageContainer::ModuleErrorType::ERROR_IN_DEFAULTS,
+        ModulePackageContainer::ModuleErrorType::ERROR_IN_LATEST
+    };
+    constexpr size_t attemptsCount = sizeof(attemptFlags) / sizeof(attemptFlags[0]);
+
+    // declared before the futures, running attempts are waited for before the sacks are freed
+    std::vector<std::unique_ptr<DnfSack>> sacks;
+    std::vector<std::future<ModuleSolveAttempt>> futures;
+    for (size_t i = 0; i < attemptsCount; ++i) {
+        sacks.emplace_back(cloneModuleSack(moduleSack));
+        futures.push_back(std::async(std::launch::async, solveModuleAttempt, sacks.back().get(),
+                                     std::cref(provides), attemptFlags[i], i == 0,
+                                     i == attemptsCount - 1));
+    }
+    std::vector<ModuleSolveAttempt> attempts;
+    std::exception_ptr error;
+    for (auto & future : futures) {
+        try {
+            attempts.push_back(future.get());
+        } catch (...) {
+            attempts.emplace_back();
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    sacks.clear();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    for (size_t i = 0; i < attemptsCount; ++i) {
+        if (!attempts[i].solved) {
+            continue;
+        }
+        problems = std::move(attempts[0].problems);
+        problemType = attemptErrors[i];
+        std::vector<const char *> moduleNames;
+        for (const auto & name : attempts[i].installNames) {
+            moduleNames.push_back(name.c_str());
+        }
+        moduleNames.push_back(nullptr);
+        Query query(moduleSack, Query::ExcludeFlags::IGNORE_EXCLUDES);
+        query.addFilter(HY_PKG_NAME, HY_EQ, moduleNames.data());
+        activatedModules.reset(new PackageSet(*query.runSet()));
+        return true;
+    }
+
+    problems = std::move(attempts[0].problems);
+    conflictingPkgs.reset(new PackageSet(moduleSack));
+    auto & conflictNevras = attempts[attemptsCount - 1].conflictNevras;
+    if (!conflictNevras.empty()) {
+        std::vector<const char *> nevras;
+        for (const auto & nevra : conflictNevras) {
+            nevras.push_back(nevra.c_str());
+        }
+        nevras.push_back(nullptr);
+        Query query(moduleSack, Query::ExcludeFlags::IGNORE_EXCLUDES);
+        query.available();
+        query.addFilter(HY_PKG_NEVRA_STRICT, HY_EQ, nevras.data());
+        *conflictingPkgs += *query.runSet();
+    }
+    return false;
+}
+
 std::pair<std::vector<std::vector<std::string>>, ModulePackageContainer::ModuleErrorType>
 ModulePackageContainer::Impl::moduleSolve(const std::vector<ModulePackage *> & modules,
     bool debugSolver)
@@ -689,6 +991,15 @@ ModulePackageContainer::Impl::moduleSolve(const std::vector<ModulePackage *> & m
     }
     dnf_sack_recompute_considered(moduleSack);
     dnf_sack_make_provides_ready(moduleSack);
+    std::vector<std::vector<std::string>> problems;
+    auto problemType = ModulePackageContainer::ModuleErrorType::NO_ERROR;
+    // Set when no goal can be solved, the modules have to be reduced
+    std::unique_ptr<PackageSet> conflictingPkgs;
+    if (parallelSolving && !debugSolver) {
+        if (moduleSolveParallel(modules, problems, problemType, conflictingPkgs)) {
+            return make_pair(problems, problemType);
+        }
+    }
     Goal goal(moduleSack);
     Goal goalWeak(moduleSack);
     for (const auto &module : modules) {
@@ -701,46 +1012,49 @@ ModulePackageContainer::Impl::moduleSolve(const std::vector<ModulePackage *> & m
         goal.install(&selector, optional);
         goalWeak.install(&selector, true);
     }
-    auto ret = goal.run(static_cast<DnfGoalActions>(DNF_IGNORE_WEAK | DNF_FORCE_BEST));
-    if (debugSolver) {
-        goal.writeDebugdata("debugdata/modules");
-    }
-    std::vector<std::vector<std::string>> problems;
-    auto problemType = ModulePackageContainer::ModuleErrorType::NO_ERROR;
-    if (ret) {
-        // Goal run ignor problem in defaults
-        problems = goal.describeAllProblemRules(false);
-        ret = goal.run(DNF_FORCE_BEST);
+    if (!conflictingPkgs) {
+        auto ret = goal.run(static_cast<DnfGoalActions>(DNF_IGNORE_WEAK | DNF_FORCE_BEST));
+        if (debugSolver) {
+            goal.writeDebugdata("debugdata/modules");
+        }
         if (ret) {
-            // Goal run ignor problem in defaults and in latest
-            ret = goal.run(DNF_NONE);
+            // Goal run ignor problem in defaults
+            problems = goal.describeAllProblemRules(false);
+            ret = goal.run(DNF_FORCE_BEST);
             if (ret) {
-                // Conflicting modules has to be removed otherwice it could result than one of them will
-                // be active
-                auto conflictingPkgs = goal.listConflictPkgs(DNF_PACKAGE_STATE_AVAILABLE);
-                dnf_sack_add_excludes(moduleSack, conflictingPkgs.get());
-                ret = goalWeak.run(DNF_NONE);
+                // Goal run ignor problem in defaults and in latest
+                ret = goal.run(DNF_NONE);
                 if (ret) {
-                    auto logger(Log::getLogger());
-                    logger->critical("Modularity filtering totally broken\n");
-                    problemType = ModulePackageContainer::ModuleErrorType::CANNOT_RESOLVE_MODULES;
-                    activatedModules.reset();
+                    conflictingPkgs = goal.listConflictPkgs(DNF_PACKAGE_STATE_AVAILABLE);
                 } else {
-                    problemType = ModulePackageContainer::ModuleErrorType::ERROR;
-                    Query query(moduleSack, Query::ExcludeFlags::IGNORE_EXCLUDES);
-                    goal2name_query(goalWeak, query);
-                    activatedModules.reset(new PackageSet(*query.runSet()));
+                    problemType = ModulePackageContainer::ModuleErrorType::ERROR_IN_LATEST;
                 }
-                return make_pair(problems, problemType);
+            } else {
+                problemType = ModulePackageContainer::ModuleErrorType::ERROR_IN_DEFAULTS;
             }
-            problemType = ModulePackageContainer::ModuleErrorType::ERROR_IN_LATEST;
-        } else {
-            problemType = ModulePackageContainer::ModuleErrorType::ERROR_IN_DEFAULTS;
+        }
+        if (!conflictingPkgs) {
+            Query query(moduleSack, Query::ExcludeFlags::IGNORE_EXCLUDES);
+            goal2name_query(goal, query);
+            activatedModules.reset(new PackageSet(*query.runSet()));
+            return make_pair(problems, problemType);
         }
     }
-    Query query(moduleSack, Query::ExcludeFlags::IGNORE_EXCLUDES);
-    goal2name_query(goal, query);
-    activatedModules.reset(new PackageSet(*query.runSet()));
+    // Conflicting modules has to be removed otherwice it could result than one of them will
+    // be active
+    dnf_sack_add_excludes(moduleSack, conflictingPkgs.get());
+    auto ret = goalWeak.run(DNF_NONE);
+    if (ret) {
+        auto logger(Log::getLogger());
+        logger->critical("Modularity filtering totally broken\n");
+        problemType = ModulePackageContainer::ModuleErrorType::CANNOT_RESOLVE_MODULES;
+        activatedModules.reset();
+    } else {
+        problemType = ModulePackageContainer::ModuleErrorType::ERROR;
+        Query query(moduleSack, Query::ExcludeFlags::IGNORE_EXCLUDES);
+        goal2name_query(goalWeak, query);
+        activatedModules.reset(new PackageSet(*query.runSet()));
+    }
     return make_pair(problems, problemType);
 }
 
@@ -776,6 +1090,10 @@ ModulePackageContainer::query(std::string name, std::string stream, std::string
     std::string context, std::string arch)
 {
     pImpl->addVersion2Modules();
+    if (!name.empty() && !stream.empty() &&
+        !hy_is_glob_pattern(name.c_str()) && !hy_is_glob_pattern(stream.c_str())) {
+        return pImpl->queryIndex(name, stream, version, context, arch);
+    }
     // Alternatively a search using module provides could be performed
     std::vector<ModulePackage *> result;
     Query query(pImpl->moduleSack, Query::ExcludeFlags::IGNORE_EXCLUDES);
@@ -803,48 +1121,128 @@ ModulePackageContainer::query(std::string name, std::string stream, std::string
     return result;
 }
 
+const ModulePackageContainer::Impl::ModuleIndex &
+ModulePackageContainer::Impl::getModuleIndex()
+{
+    if (moduleIndex) {
+        return *moduleIndex;
+    }
+    moduleIndex.reset(new ModuleIndex);
+    Pool * pool = dnf_sack_get_pool(moduleSack);
+    for (auto & modulePair : modules) {
+        auto modulePackage = modulePair.second.get();
+        // same as Query::available()
+        if (pool_id2solvable(pool, modulePair.first)->repo == pool->installed) {
+            continue;
+        }
+        auto nameStream = modulePackage->getNameStream();
+        moduleIndex->byNameStreamContext[nameStream + ":" + modulePackage->getContext()].push_back(
+            modulePackage);
+        moduleIndex->byNameStream[std::move(nameStream)].push_back(modulePackage);
+    }
+    return *moduleIndex;
+}
+
+static bool
+matchesOptionalGlob(const std::string & pattern, const std::string & value)
+{
+    if (pattern.empty()) {
+        return true;
+    }
+    if (hy_is_glob_pattern(pattern.c_str())) {
+        return fnmatch(pattern.c_str(), value.c_str(), 0) == 0;
+    }
+    return pattern == value;
+}
+
+std::vector<ModulePackage *>
+ModulePackageContainer::Impl::queryIndex(const std::string & name, const std::string & stream,
+    const std::string & version, const std::string & context, const std::string & arch)
+{
+    auto & index = getModuleIndex();
+    std::vector<ModulePackage *> result;
+    auto key = name + ":" + stream;
+    const std::unordered_map<std::string, std::vector<ModulePackage *>> * map = &index.byNameStream;
+    bool contextIndexed = !context.empty() && !hy_is_glob_pattern(context.c_str());
+    if (contextIndexed) {
+        key += ":" + context;
+        map = &index.byNameStreamContext;
+    }
+    auto it = map->find(key);
+    if (it == map->end()) {
+        return result;
+    }
+    Pool * pool = dnf_sack_get_pool(moduleSack);
+    for (auto modulePackage : it->second) {
+        // modules without arch are stored as noarch solvables
+        auto solvable = pool_id2solvable(pool, modulePackage->getId());
+        if ((contextIndexed || matchesOptionalGlob(context, modulePackage->getContext())) &&
+            matchesOptionalGlob(arch, pool_id2str(pool, solvable->arch)) &&
+            matchesOptionalGlob(version, modulePackage->getVersion())) {
+            result.push_back(modulePackage);
+        }
+    }
+    return result;
+}
+
 void ModulePackageContainer::enableDependencyTree(std::vector<ModulePackage *> & modulePackages)
 {
     if (!pImpl->activatedModules) {
         return;
     }
-    PackageSet toEnable(pImpl->moduleSack);
-    PackageSet enabled(pImpl->moduleSack);
+    auto moduleSack = pImpl->moduleSack;
+    Pool * pool = dnf_sack_get_pool(moduleSack);
+    dnf_sack_make_provides_ready(moduleSack);
+
+    // Active modules that are not excluded, same as a Query limited to activatedModules
+    Map active;
+    map_init_clone(&active, pImpl->activatedModules->getMap());
+    map_grow(&active, pool->nsolvables);
+    auto considered = dnf_sack_get_considered_map(moduleSack, Query::ExcludeFlags::APPLY_EXCLUDES);
+    if (considered) {
+        map_and(&active, considered);
+    }
+    Map enabled;
+    map_init(&enabled, pool->nsolvables);
+    Queue toResolve;
+    queue_init(&toResolve);
+    Queue requires;
+    queue_init(&requires);
+
     for (auto & modulePackage: modulePackages) {
         if (!isModuleActive(modulePackage)) {
             continue;
         }
-        Query query(pImpl->moduleSack);
-        query.addFilter(HY_PKG, HY_EQ, pImpl->activatedModules.get());
-        auto pkg = dnf_package_new(pImpl->moduleSack, modulePackage->getId());
-        auto dep_requires = dnf_package_get_requires(pkg);
-        query.addFilter(HY_PKG_PROVIDES, dep_requires);
-        auto set = query.runSet();
-        toEnable += *set;
-        delete dep_requires;
-        g_object_unref(pkg);
         enable(modulePackage);
-        enabled.set(modulePackage->getId());
+        Id moduleId = modulePackage->getId();
+        if (!MAPTST(&enabled, moduleId)) {
+            MAPSET(&enabled, moduleId);
+            queue_push(&toResolve, moduleId);
+        }
     }
-    toEnable -= enabled;
-    while (!toEnable.empty()) {
-        Id moduleId = -1;
-        while ((moduleId = toEnable.next(moduleId)) != -1) {
-            enable(pImpl->modules.at(moduleId).get());
-            enabled.set(moduleId);
-            Query query(pImpl->moduleSack);
-            query.addFilter(HY_PKG, HY_EQ, pImpl->activatedModules.get());
-            query.addFilter(HY_PKG, HY_NEQ, &enabled);
-            auto pkg = dnf_package_new(pImpl->moduleSack, moduleId);
-            auto dep_requires = dnf_package_get_requires(pkg);
-            query.addFilter(HY_PKG_PROVIDES, dep_requires);
-            auto set = query.runSet();
-            toEnable += *set;
-            delete dep_requires;
-            g_object_unref(pkg);
+    // Requires of each enabled module are resolved exactly once
+    while (toResolve.count) {
+        Solvable * s = pool_id2solvable(pool, queue_shift(&toResolve));
+        // requires and pre-requires, see dnf_package_get_requires()
+        for (Id marker : {-1, 1}) {
+            solvable_lookup_deparray(s, SOLVABLE_REQUIRES, &requires, marker);
+            for (int i = 0; i < requires.count; ++i) {
+                Id p, pp;
+                FOR_PROVIDES(p, pp, requires.elements[i]) {
+                    if (MAPTST(&active, p) && !MAPTST(&enabled, p)) {
+                        enable(pImpl->modules.at(p).get());
+                        MAPSET(&enabled, p);
+                        queue_push(&toResolve, p);
+                    }
+                }
+            }
         }
-        toEnable -= enabled;
     }
+
+    queue_free(&requires);
+    queue_free(&toResolve);
+    map_free(&enabled);
+    map_free(&active);
 }
 
 ModulePackageContainer::ModuleState
@@ -1170,9 +1568,20 @@ ModulePackageContainer::resolveActiveModulePackages(bool debugSolver)
     }
     dnf_sack_add_excludes(pImpl->moduleSack, &excludes);
     auto problems = pImpl->moduleSolve(packages, debugSolver);
+    ++pImpl->activeGeneration;
     return problems;
 }
 
+void ModulePackageContainer::setParallelSolving(bool enable)
+{
+    pImpl->parallelSolving = enable;
+}
+
+unsigned long ModulePackageContainer::getActiveGeneration() const
+{
+    return pImpl->activeGeneration;
+}
+
 bool ModulePackageContainer::isModuleActive(Id id)
 {
     if (pImpl->activatedModules) {
@@ -1701,8 +2110,9 @@ void ModulePackageContainer::loadFailSafeData()
                 g_autofree gchar * file = g_build_filename(
                     pImpl->persistDir.c_str(), low->c_str(), NULL);
                 try {
-                    auto yamlContent = getFileContent(file);
-                    add(yamlContent, LIBDNF_MODULE_FAIL_SAFE_REPO_NAME);
+                    ModuleMetadata md;
+                    md.addMetadataFromFile(file, 0);
+                    pImpl->addModules(md, LIBDNF_MODULE_FAIL_SAFE_REPO_NAME);
                     loaded = true;
                 } catch (const std::exception &) {
                     auto logger(Log::getLogger());
@@ -1755,6 +2165,7 @@ void ModulePackageContainer::Impl::addVersion2Modules()
     ModulemdModuleStream * mdStream;
     std::string repoID;
     g_autofree gchar * path = g_build_filename(installRoot.c_str(), "/etc/dnf/modules.d", NULL);
+    moduleIndex.reset();
     for (auto & module_tuple : modulesV2) {
         std::tie(repo, mdStream, repoID) = module_tuple;
         auto nameStream = ModulePackage::getNameStream(mdStream);
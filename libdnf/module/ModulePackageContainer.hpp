@@ -294,6 +294,17 @@ public:
         std::string version, std::string context, std::string arch);
     void enableDependencyTree(std::vector<ModulePackage *> & modulePackages);
     std::pair<std::vector<std::vector<std::string>>, ModulePackageContainer::ModuleErrorType> resolveActiveModulePackages(bool debugSolver);
+    /**
+    * @brief Solve the strict and the relaxed module goals concurrently, each on its own copy of
+    * the module pool. The strictest successful result is used, therefore the outcome is the same
+    * as with the sequential solving. Disabled by default.
+    */
+    void setParallelSolving(bool enable);
+    /**
+    * @brief Returns a counter that changes whenever the set of active modules is recomputed, it
+    * allows callers to cache results derived from isModuleActive().
+    */
+    unsigned long getActiveGeneration() const;
     bool isModuleActive(Id id);
     bool isModuleActive(const ModulePackage * modulePackage);
     void loadFailSafeData();
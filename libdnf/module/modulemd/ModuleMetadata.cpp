@@ -21,6 +21,7 @@
 #include "ModuleMetadata.hpp"
 
 #include "../ModulePackageContainer.hpp"
+#include "../../utils/File.hpp"
 
 #include "bgettext/bgettext-lib.h"
 #include "tinyformat/tinyformat.hpp"
@@ -82,9 +83,68 @@ void ModuleMetadata::addMetadataFromString(const std::string & yaml, int priorit
     if(!success){
         ModuleMetadata::reportFailures(failures);
     }
-    if (error)
+    if (error) {
+        g_object_unref(mi);
         throw ModulePackageContainer::ResolveException( tfm::format(_("Failed to update from string: %s"), error->message));
+    }
+
+    addModuleIndex(mi, priority);
+}
+
+namespace {
 
+struct FileReadData {
+    File * file;
+    std::string error;
+};
+
+/// ModulemdReadHandler feeding the YAML parser from a File
+int readFileChunk(void * data, unsigned char * buffer, size_t size, size_t * sizeRead)
+{
+    auto readData = static_cast<FileReadData *>(data);
+    try {
+        *sizeRead = readData->file->read(reinterpret_cast<char *>(buffer), size);
+        return 1;
+    } catch (const std::exception & ex) {
+        readData->error = ex.what();
+        return 0;
+    }
+}
+
+}
+
+void ModuleMetadata::addMetadataFromFile(const std::string & filePath, int priority)
+{
+    GError *error = NULL;
+    g_autoptr(GPtrArray) failures = NULL;
+
+    auto file = File::newFile(filePath);
+    file->open("r");
+    FileReadData readData{file.get(), {}};
+
+    ModulemdModuleIndex * mi = modulemd_module_index_new();
+    gboolean success = modulemd_module_index_update_from_custom(mi, readFileChunk, &readData, FALSE,
+                                                                &failures, &error);
+    file->close();
+    if(!success){
+        ModuleMetadata::reportFailures(failures);
+    }
+    if (!readData.error.empty()) {
+        g_object_unref(mi);
+        g_clear_error(&error);
+        throw File::ReadError(readData.error);
+    }
+    if (error) {
+        g_object_unref(mi);
+        throw ModulePackageContainer::ResolveException(tfm::format(_("Failed to update from file \"%s\": %s"),
+                                                                   filePath, error->message));
+    }
+
+    addModuleIndex(mi, priority);
+}
+
+void ModuleMetadata::addModuleIndex(ModulemdModuleIndex * mi, int priority)
+{
     if (!moduleMerger){
         moduleMerger = modulemd_module_index_merger_new();
         if (resultingModuleIndex){
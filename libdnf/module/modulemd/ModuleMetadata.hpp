@@ -35,6 +35,8 @@ public:
     ModuleMetadata & operator=(const ModuleMetadata & m);
     ~ModuleMetadata();
     void addMetadataFromString(const std::string & yaml, int priority);
+    /// Parses the (possibly compressed) file while it is being read, the content is not kept in memory.
+    void addMetadataFromFile(const std::string & filePath, int priority);
     void resolveAddedMetadata();
     std::vector<ModulePackage *> getAllModulePackages(DnfSack * moduleSack, LibsolvRepo * repo, const std::string & repoID, std::vector<std::tuple<LibsolvRepo *, ModulemdModuleStream *, std::string>> & modulesV2);
     std::map<std::string, std::string> getDefaultStreams();
@@ -43,6 +45,7 @@ public:
 
 private:
     static void reportFailures(const GPtrArray *failures);
+    void addModuleIndex(ModulemdModuleIndex * mi, int priority);
     ModulemdModuleIndex * resultingModuleIndex;
     ModulemdModuleIndexMerger * moduleMerger;
 };
@@ -75,18 +75,7 @@ AdvisoryModule::nsvcaEQ(AdvisoryModule & other)
 
 bool
 AdvisoryModule::isApplicable() const {
-    auto moduleContainer = dnf_sack_get_module_container(pImpl->sack);
-    if (!moduleContainer) {
-        return false;
-    }
-
-    for (auto & module : moduleContainer->query(getName(), getStream(), {}, getContext(), {})) {
-        if (moduleContainer->isModuleActive(module)) {
-            return true;
-        }
-    }
-
-    return false;
+    return dnf_sack_is_module_applicable(pImpl->sack, pImpl->name, pImpl->stream, pImpl->context);
 }
 
 Advisory * AdvisoryModule::getAdvisory() const
@@ -62,29 +62,6 @@ struct default_delete<DnfPackage> {
 
 namespace libdnf {
 
-struct NevraID {
-public:
-    NevraID() : name(0), arch(0), evr(0) {};
-    NevraID(const NevraID & src) = default;
-    NevraID(NevraID && src) noexcept = default;
-    NevraID & operator=(const NevraID & src) = default;
-    NevraID & operator=(NevraID && src) = default;
-    Id name;
-    Id arch;
-    Id evr;
-    std::string evr_str;
-    /**
-    * @brief Parsing function for nevra string into name, evr, arch and transforming it into libsolv
-    * Id
-    *
-    * int createNewEVR - `1` will create new id for evr when it is unknown, `0` will exit with false when evr is unknown
-    *
-    * @return bool Returns true if parsing succesful and all elements is known to pool
-    */
-
-    bool parse(Pool * pool, const char * nevraPattern, bool createEVRId);
-};
-
 bool
 NevraID::parse(Pool * pool, const char * nevraPattern, bool createEVRId)
 {
@@ -216,7 +193,8 @@ NameArchPrioritySolvableKey(const Solvable * first, const Solvable * second)
 }
 
 struct NameArchEVRComparator {
-   NameArchEVRComparator(Pool * pool) : pool(pool) {};
+   NameArchEVRComparator(Pool * pool, const std::vector<int> & evrRanks)
+   : pool(pool), evrRanks(evrRanks) {};
    bool operator()(const Solvable * first, const Solvable * second) {
        if (first->name != second->name) {
           return first->name < second->name;
@@ -224,7 +202,7 @@ struct NameArchEVRComparator {
        if (first->arch != second->arch) {
           return first->arch < second->arch;
        }
-       return pool_evrcmp(pool, first->evr, second->evr, EVRCMP_COMPARE) < 0;
+       return dnf_sack_evr_rank_cmp(pool, evrRanks, first->evr, second->evr) < 0;
    }
    bool operator()(const Solvable * solvable, const AdvisoryPkg & pkg) {
        if (pkg.getName() != solvable->name) {
@@ -237,6 +215,7 @@ struct NameArchEVRComparator {
    }
 
    Pool * pool;
+   const std::vector<int> & evrRanks;
 };
 
 
@@ -505,17 +484,23 @@ pool_solvable_epoch_optional_2str(Pool *pool, const Solvable *s, gboolean with_e
     return output_string;
 }
 
+struct LatestSortContext {
+    Pool * pool;
+    const std::vector<int> & evrRanks;
+};
+
 static int
 filter_latest_sortcmp(const void *ap, const void *bp, void *dp)
 {
-    auto pool = static_cast<Pool *>(dp);
+    auto ctx = static_cast<LatestSortContext *>(dp);
+    Pool *pool = ctx->pool;
     Solvable *sa = pool->solvables + *(Id *)ap;
     Solvable *sb = pool->solvables + *(Id *)bp;
     int r;
     r = sa->name - sb->name;
     if (r)
         return r;
-    r = pool_evrcmp(pool, sb->evr, sa->evr, EVRCMP_COMPARE);
+    r = dnf_sack_evr_rank_cmp(pool, ctx->evrRanks, sb->evr, sa->evr);
     if (r)
         return r;
     return *(Id *)ap - *(Id *)bp;
@@ -524,7 +509,8 @@ filter_latest_sortcmp(const void *ap, const void *bp, void *dp)
 static int
 filter_latest_sortcmp_byarch(const void *ap, const void *bp, void *dp)
 {
-    auto pool = static_cast<Pool *>(dp);
+    auto ctx = static_cast<LatestSortContext *>(dp);
+    Pool *pool = ctx->pool;
     Solvable *sa = pool->solvables + *(Id *)ap;
     Solvable *sb = pool->solvables + *(Id *)bp;
     int r;
@@ -534,7 +520,7 @@ filter_latest_sortcmp_byarch(const void *ap, const void *bp, void *dp)
     r = sa->arch - sb->arch;
     if (r)
         return r;
-    r = pool_evrcmp(pool, sb->evr, sa->evr, EVRCMP_COMPARE);
+    r = dnf_sack_evr_rank_cmp(pool, ctx->evrRanks, sb->evr, sa->evr);
     if (r)
         return r;
     return *(Id *)ap - *(Id *)bp;
@@ -543,7 +529,8 @@ filter_latest_sortcmp_byarch(const void *ap, const void *bp, void *dp)
 static int
 filter_latest_sortcmp_byarch_bypriority(const void *ap, const void *bp, void *dp)
 {
-    auto pool = static_cast<Pool *>(dp);
+    auto ctx = static_cast<LatestSortContext *>(dp);
+    Pool *pool = ctx->pool;
     Solvable *sa = pool->solvables + *(Id *)ap;
     Solvable *sb = pool->solvables + *(Id *)bp;
     int r;
@@ -556,7 +543,7 @@ filter_latest_sortcmp_byarch_bypriority(const void *ap, const void *bp, void *dp
     r = sb->repo->priority - sa->repo->priority;
     if (r)
         return r;
-    r = pool_evrcmp(pool, sb->evr, sa->evr, EVRCMP_COMPARE);
+    r = dnf_sack_evr_rank_cmp(pool, ctx->evrRanks, sb->evr, sa->evr);
     if (r)
         return r;
     return *(Id *)ap - *(Id *)bp;
@@ -794,7 +781,6 @@ private:
     std::unique_ptr<PackageSet> result;
     std::vector<Filter> filters;
     void apply();
-    Map *considered_cached = nullptr;
 
     /**
     * @brief It accepts strings of whole NEVRA and apply them to the query. It requires full
@@ -836,11 +822,7 @@ private:
     bool isGlob(const std::vector<const char *> &matches) const;
 };
 
-Query::Impl::~Impl()
-{
-    if (considered_cached)
-        free_map_fully(considered_cached);
-}
+Query::Impl::~Impl() = default;
 
 Query::Impl::Impl(DnfSack* sack, Query::ExcludeFlags flags)
 : sack(sack), flags(flags) {}
@@ -1214,16 +1196,9 @@ Query::Impl::initResult()
             result->set(solvid);
         dnf_sack_set_pkg_solvables(sack, result->getMap(), pool->nsolvables);
     }
-    if (flags == Query::ExcludeFlags::APPLY_EXCLUDES) {
-        dnf_sack_recompute_considered(sack);
-        if (pool->considered)
-            map_and(result->getMap(), pool->considered);
-    } else {
-        dnf_sack_recompute_considered_map(sack, &considered_cached, flags);
-        if (considered_cached) {
-            map_and(result->getMap(), considered_cached);
-        }
-    }
+    auto considered = dnf_sack_get_considered_map(sack, flags);
+    if (considered)
+        map_and(result->getMap(), considered);
 }
 
 void
@@ -1245,29 +1220,31 @@ Query::Impl::filterDepSolvable(const Filter & f, Map * m)
     dnf_sack_make_provides_ready(sack);
     Pool * pool = dnf_sack_get_pool(sack);
     Id rco_key = reldep_keyname2id(f.getKeyname());
+    auto resultMap = result->getMap();
 
-    IdQueue out;
+    IdQueue provides;
+    IdQueue candidates;
 
     const auto filter_pset = f.getMatches()[0].pset;
     Id id = -1;
     while ((id = filter_pset->next(id)) != -1) {
-        out.clear();
-
-        // queue_push2 because we are creating a selection, which contains pairs
-        // of <flags, Id>, SOLVER_SOOLVABLE_ALL is a special flag which includes
-        // all packages from specified pool, Id is ignored.
-        out.pushBack(SOLVER_SOLVABLE_ALL, 0);
-
-        int flags = 0;
-        flags |= SELECTION_FILTER | SELECTION_WITH_ALL;
-        selection_make_matchsolvable(pool, out.getQueue(), id, flags, rco_key, 0);
-
-        // Queue from selection_make_matchsolvable is a selection, which means
-        // it conntains pairs <flags, Id>, flags refers to how was the Id
-        // matched, that is not important here, so skip it and iterate just
-        // over the Ids.
-        for (int j = 1; j < out.size(); j += 2) {
-            MAPSET(m, out[j]);
+        // Only packages with a dependency on one of the provided names can match the package,
+        // take them from the reverse index instead of testing every solvable in the pool.
+        provides.clear();
+        candidates.clear();
+        solvable_lookup_idarray(pool_id2solvable(pool, id), SOLVABLE_PROVIDES, provides.getQueue());
+        for (int i = 0; i < provides.size(); ++i) {
+            dnf_sack_get_rco_candidates(sack, rco_key, provides[i], candidates.getQueue());
+        }
+        for (int i = 0; i < candidates.size(); ++i) {
+            Id candidateId = candidates[i];
+            if (!MAPTST(resultMap, candidateId) || MAPTST(m, candidateId)) {
+                continue;
+            }
+            Solvable * candidate = pool_id2solvable(pool, candidateId);
+            if (solvable_matchessolvable(candidate, rco_key, id, nullptr, 0)) {
+                MAPSET(m, candidateId);
+            }
         }
     }
 }
@@ -1277,17 +1254,25 @@ Query::Impl::filterRcoReldep(const Filter & f, Map *m)
 {
     assert(f.getMatchType() == _HY_RELDEP);
 
+    dnf_sack_make_provides_ready(sack);
     Pool *pool = dnf_sack_get_pool(sack);
     Id rco_key = reldep_keyname2id(f.getKeyname());
     Queue rco;
-    auto resultPset = result.get();
+    Queue candidates;
+    auto resultMap = result->getMap();
 
     queue_init(&rco);
-    Id resultId = -1;
-    while ((resultId = resultPset->next(resultId)) != -1) {
-        Solvable *s = pool_id2solvable(pool, resultId );
-        for (auto match : f.getMatches()) {
-            Id reldepFilterId = match.reldep;
+    queue_init(&candidates);
+    for (auto match : f.getMatches()) {
+        Id reldepFilterId = match.reldep;
+
+        queue_empty(&candidates);
+        dnf_sack_get_rco_candidates(sack, rco_key, reldepFilterId, &candidates);
+        for (int i = 0; i < candidates.count; ++i) {
+            Id candidateId = candidates.elements[i];
+            if (!MAPTST(resultMap, candidateId) || MAPTST(m, candidateId))
+                continue;
+            Solvable *s = pool_id2solvable(pool, candidateId);
 
             queue_empty(&rco);
             solvable_lookup_idarray(s, rco_key, &rco);
@@ -1295,13 +1280,13 @@ Query::Impl::filterRcoReldep(const Filter & f, Map *m)
                 Id reldepIdFromSolvable = rco.elements[j];
 
                 if (pool_match_dep(pool, reldepFilterId, reldepIdFromSolvable )) {
-                    MAPSET(m, resultId );
-                    goto nextId;
+                    MAPSET(m, candidateId);
+                    break;
                 }
             }
         }
-        nextId:;
     }
+    queue_free(&candidates);
     queue_free(&rco);
 }
 
@@ -1966,7 +1951,7 @@ Query::Impl::filterAdvisory(const Filter & f, Map *m, int keyname)
             }
         }
 
-        NameArchEVRComparator cmp_key(pool);
+        NameArchEVRComparator cmp_key(pool, dnf_sack_get_evr_ranks(sack));
         std::sort(candidates.begin(), candidates.end(), cmp_key);
         for (auto & advisoryPkg : pkgs) {
             if (cmp_type & HY_UPGRADE) {
@@ -2045,15 +2030,16 @@ Query::Impl::filterLatest(const Filter & f, Map *m)
             queue_push(&samename, id);
         }
 
+        LatestSortContext ctx{pool, dnf_sack_get_evr_ranks(sack)};
         if (keyname == HY_PKG_LATEST_PER_ARCH) {
             solv_sort(samename.elements, samename.count, sizeof(Id),
-                      filter_latest_sortcmp_byarch, pool);
+                      filter_latest_sortcmp_byarch, &ctx);
         } else if (keyname == HY_PKG_LATEST_PER_ARCH_BY_PRIORITY) {
             solv_sort(samename.elements, samename.count, sizeof(Id),
-                      filter_latest_sortcmp_byarch_bypriority, pool);
+                      filter_latest_sortcmp_byarch_bypriority, &ctx);
         } else {
             solv_sort(samename.elements, samename.count, sizeof(Id),
-                      filter_latest_sortcmp, pool);
+                      filter_latest_sortcmp, &ctx);
         }
 
         // Create blocks per name, arch and repo priority
@@ -2122,9 +2108,9 @@ Query::Impl::filterUpdown(const Filter & f, Map *m)
             if (s->repo == pool->installed)
                 continue;
             if (f.getKeyname() == HY_PKG_DOWNGRADES) {
-                if (what_downgrades(pool, id) > 0)
+                if (what_downgrades(sack, id) > 0)
                     MAPSET(m, id);
-            } else if (what_upgrades(pool, id) > 0)
+            } else if (what_upgrades(sack, id) > 0)
                 MAPSET(m, id);
         }
     }
@@ -2165,12 +2151,12 @@ Query::Impl::filterUpdownByPriority(const Filter & f, Map *m)
                 name = candidate->name;
                 priority = candidate->repo->priority;
                 id = pool_solvable2id(pool, candidate);
-                if (what_upgrades(pool, id) > 0) {
+                if (what_upgrades(sack, id) > 0) {
                     MAPSET(m, id);
                 }
             } else if (priority == candidate->repo->priority) {
                 id = pool_solvable2id(pool, candidate);
-                if (what_upgrades(pool, id) > 0) {
+                if (what_upgrades(sack, id) > 0) {
                     MAPSET(m, id);
                 }
             }
@@ -2191,25 +2177,21 @@ Query::Impl::filterUpdownAble(const Filter  &f, Map *m)
         return;
     }
     auto resultMap = result->getMap();
+    auto considered = dnf_sack_get_considered_map(sack, flags);
 
     for (auto match_in : f.getMatches()) {
         if (match_in.num == 0)
             continue;
 
         FOR_PKG_SOLVABLES(p) {
-            if (flags == Query::ExcludeFlags::APPLY_EXCLUDES) {
-                if (pool->considered && !map_tst(pool->considered, p))
-                    continue;
-            } else {
-                if (considered_cached && !map_tst(considered_cached, p))
-                    continue;
-            }
+            if (considered && !MAPTST(considered, p))
+                continue;
             s = pool_id2solvable(pool, p);
             if (s->repo == pool->installed)
                 continue;
 
-            what = (f.getKeyname() == HY_PKG_DOWNGRADABLE) ? what_downgrades(pool, p) :
-                what_upgrades(pool, p);
+            what = (f.getKeyname() == HY_PKG_DOWNGRADABLE) ? what_downgrades(sack, p) :
+                what_upgrades(sack, p);
             if (what != 0 && map_tst(resultMap, what))
                 map_set(m, what);
         }
@@ -66,7 +66,7 @@ CompsEnvironmentItem::dbSelect(int64_t pk)
         WHERE
             item_id = ?
     )**";
-    SQLite3::Query query(*conn.get(), sql);
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(pk);
     query.step();
 
@@ -95,7 +95,7 @@ CompsEnvironmentItem::dbInsert()
         VALUES
             (?, ?, ?, ?, ?)
     )**";
-    SQLite3::Statement query(*conn.get(), sql);
+    SQLite3::Statement query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(getId(),
                 getEnvironmentId(),
                 getName(),
@@ -155,7 +155,7 @@ CompsEnvironmentItem::getTransactionItem(SQLite3Ptr conn, const std::string &env
         LIMIT 1
     )**";
 
-    SQLite3::Query query(*conn, sql);
+    SQLite3::Query query(*conn, sql, SQLite3::Cached{});
     query.bindv(envid);
     if (query.step() == SQLite3::Statement::StepResult::ROW) {
         auto trans_item =
@@ -228,7 +228,7 @@ CompsEnvironmentItem::getTransactionItems(SQLite3Ptr conn, int64_t transactionId
             ti.trans_id = ?
             AND ti.item_id = i.item_id
     )**";
-    SQLite3::Query query(*conn.get(), sql);
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(transactionId);
 
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
@@ -251,6 +251,62 @@ CompsEnvironmentItem::getTransactionItems(SQLite3Ptr conn, int64_t transactionId
     return result;
 }
 
+/**
+ * Load transaction items of all transactions with IDs from fromId to toId.
+ * Items of each transaction are in the same order as from getTransactionItems().
+ * \return transaction items by transaction ID
+ */
+std::map< int64_t, std::vector< TransactionItemPtr > >
+CompsEnvironmentItem::getTransactionItemsInRange(SQLite3Ptr conn, int64_t fromId, int64_t toId)
+{
+    std::map< int64_t, std::vector< TransactionItemPtr > > result;
+
+    const char *sql = R"**(
+        SELECT
+            ti.id,
+            ti.state,
+            ti.action,
+            ti.reason,
+            i.item_id,
+            i.environmentid,
+            i.name,
+            i.translated_name,
+            i.pkg_types,
+            ti.trans_id
+        FROM
+            trans_item ti,
+            comps_environment i
+        WHERE
+            ti.trans_id BETWEEN ? AND ?
+            AND ti.item_id = i.item_id
+        ORDER BY
+            ti.trans_id,
+            ti.id
+    )**";
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
+    query.bindv(fromId, toId);
+
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        auto transID = query.get< int64_t >(9);
+        auto trans_item = std::make_shared< TransactionItem >(conn, transID);
+        auto item = std::make_shared< CompsEnvironmentItem >(conn);
+        trans_item->setItem(item);
+
+        trans_item->setId(query.get< int >(0));
+        trans_item->setState(static_cast< TransactionItemState >(query.get< int >(1)));
+        trans_item->setAction(static_cast< TransactionItemAction >(query.get< int >(2)));
+        trans_item->setReason(static_cast< TransactionItemReason >(query.get< int >(3)));
+        item->setId(query.get< int >(4));
+        item->setEnvironmentId(query.get< std::string >(5));
+        item->setName(query.get< std::string >(6));
+        item->setTranslatedName(query.get< std::string >(7));
+        item->setPackageTypes(static_cast< CompsPackageType >(query.get< int >(8)));
+
+        result[transID].push_back(trans_item);
+    }
+    return result;
+}
+
 std::string
 CompsEnvironmentItem::toStr() const
 {
@@ -283,7 +339,7 @@ CompsEnvironmentItem::loadGroups()
         ORDER BY
             groupid ASC
     )**";
-    SQLite3::Query query(*conn.get(), sql);
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(getId());
 
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
@@ -349,7 +405,7 @@ CompsEnvironmentGroup::dbInsert()
         VALUES
             (?, ?, ?, ?)
     )**";
-    SQLite3::Statement query(*getEnvironment().conn, sql);
+    SQLite3::Statement query(*getEnvironment().conn, sql, SQLite3::Cached{});
     query.bindv(
         getEnvironment().getId(), getGroupId(), getInstalled(), static_cast< int >(getGroupType()));
     query.step();
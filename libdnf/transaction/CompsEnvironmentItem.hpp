@@ -21,6 +21,7 @@
 #ifndef LIBDNF_TRANSACTION_COMPSENVIRONMENTITEM_HPP
 #define LIBDNF_TRANSACTION_COMPSENVIRONMENTITEM_HPP
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -72,6 +73,8 @@ public:
         const std::string &pattern);
     static std::vector< TransactionItemPtr > getTransactionItems(SQLite3Ptr conn,
                                                                  int64_t transactionId);
+    static std::map< int64_t, std::vector< TransactionItemPtr > >
+    getTransactionItemsInRange(SQLite3Ptr conn, int64_t fromId, int64_t toId);
 
 protected:
     const ItemType itemType = ItemType::ENVIRONMENT;
@@ -135,7 +135,7 @@ CompsGroupItem::dbSelect(int64_t pk)
         "  comps_group "
         "WHERE "
         "  item_id = ?";
-    SQLite3::Query query(*conn.get(), sql);
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(pk);
     query.step();
 
@@ -163,7 +163,7 @@ CompsGroupItem::dbInsert()
         "  ) "
         "VALUES "
         "  (?, ?, ?, ?, ?)";
-    SQLite3::Statement query(*conn.get(), sql);
+    SQLite3::Statement query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(getId(),
                 getGroupId(),
                 getName(),
@@ -223,7 +223,7 @@ CompsGroupItem::getTransactionItem(SQLite3Ptr conn, const std::string &groupid)
             ti.trans_id DESC
     )**";
 
-    SQLite3::Query query(*conn, sql);
+    SQLite3::Query query(*conn, sql, SQLite3::Cached{});
     query.bindv(groupid);
     if (query.step() == SQLite3::Statement::StepResult::ROW) {
         auto trans_item =
@@ -257,7 +257,7 @@ CompsGroupItem::getTransactionItemsByPattern(SQLite3Ptr conn, const std::string
     if (conn->getPath() != ":memory:") {
         conn = std::make_shared<SQLite3>(conn->getPath());
     }
-    SQLite3::Query query(*conn, sql);
+    SQLite3::Query query(*conn, sql, SQLite3::Cached{});
     std::string pattern_sql = pattern;
     std::replace(pattern_sql.begin(), pattern_sql.end(), '*', '%');
     query.bindv(pattern, pattern, pattern);
@@ -295,7 +295,7 @@ CompsGroupItem::getTransactionItems(SQLite3Ptr conn, int64_t transactionId)
         WHERE
             ti.trans_id = ?
     )**";
-    SQLite3::Query query(*conn.get(), sql);
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(transactionId);
 
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
@@ -305,6 +305,48 @@ CompsGroupItem::getTransactionItems(SQLite3Ptr conn, int64_t transactionId)
     return result;
 }
 
+/**
+ * Load transaction items of all transactions with IDs from fromId to toId.
+ * Items of each transaction are in the same order as from getTransactionItems().
+ * \return transaction items by transaction ID
+ */
+std::map< int64_t, std::vector< TransactionItemPtr > >
+CompsGroupItem::getTransactionItemsInRange(SQLite3Ptr conn, int64_t fromId, int64_t toId)
+{
+    std::map< int64_t, std::vector< TransactionItemPtr > > result;
+
+    const char *sql = R"**(
+        SELECT
+            ti.trans_id,
+            ti.id as ti_id,
+            ti.action as ti_action,
+            ti.reason as ti_reason,
+            ti.state as ti_state,
+            i.item_id,
+            i.groupid,
+            i.name,
+            i.translated_name,
+            i.pkg_types
+        FROM
+            trans_item ti
+        JOIN
+            comps_group i USING (item_id)
+        WHERE
+            ti.trans_id BETWEEN ? AND ?
+        ORDER BY
+            ti.trans_id,
+            ti.id
+    )**";
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
+    query.bindv(fromId, toId);
+
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        auto transID = query.get< int64_t >("trans_id");
+        result[transID].push_back(compsGroupTransactionItemFromQuery(conn, query, transID));
+    }
+    return result;
+}
+
 std::string
 CompsGroupItem::toStr() const
 {
@@ -334,7 +376,7 @@ CompsGroupItem::loadPackages()
         "  comps_group_package "
         "WHERE "
         "  group_id = ?";
-    SQLite3::Query query(*conn.get(), sql);
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(getId());
 
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
@@ -399,7 +441,7 @@ CompsGroupPackage::dbInsert()
         VALUES
             (?, ?, ?, ?)
     )**";
-    SQLite3::Statement query(*getGroup().conn.get(), sql);
+    SQLite3::Statement query(*getGroup().conn.get(), sql, SQLite3::Cached{});
     query.bindv(
         getGroup().getId(), getName(), getInstalled(), static_cast< int >(getPackageType()));
     query.step();
@@ -418,7 +460,7 @@ CompsGroupPackage::dbUpdate()
         WHERE
             id = ?
     )**";
-    SQLite3::Statement query(*getGroup().conn.get(), sql);
+    SQLite3::Statement query(*getGroup().conn.get(), sql, SQLite3::Cached{});
     query.bindv(
         getName(), getInstalled(), static_cast< int >(getPackageType()), getId());
     query.step();
@@ -438,7 +480,7 @@ CompsGroupPackage::dbSelectOrInsert()
             AND group_id = ?
     )**";
 
-    SQLite3::Statement query(*getGroup().conn.get(), sql);
+    SQLite3::Statement query(*getGroup().conn.get(), sql, SQLite3::Cached{});
     query.bindv(getName(), getGroup().getId());
     SQLite3::Statement::StepResult result = query.step();
 
@@ -23,6 +23,7 @@
 
 #include "libdnf/error.hpp"
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -108,6 +109,8 @@ public:
         const std::string &pattern);
     static std::vector< TransactionItemPtr > getTransactionItems(SQLite3Ptr conn,
                                                                  int64_t transactionId);
+    static std::map< int64_t, std::vector< TransactionItemPtr > >
+    getTransactionItemsInRange(SQLite3Ptr conn, int64_t fromId, int64_t toId);
 
 protected:
     const ItemType itemType = ItemType::GROUP;
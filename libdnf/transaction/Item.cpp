@@ -41,7 +41,7 @@ Item::dbInsert()
         "  item "
         "VALUES "
         "  (null, ?)";
-    SQLite3::Statement query(*conn.get(), sql);
+    SQLite3::Statement query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(static_cast< int >(itemType));
     query.step();
     setId(conn->lastInsertRowID());
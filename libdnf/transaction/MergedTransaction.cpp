@@ -19,6 +19,8 @@
  */
 
 #include "MergedTransaction.hpp"
+#include "CompsEnvironmentItem.hpp"
+#include "CompsGroupItem.hpp"
 #include <algorithm>
 #include <vector>
 
@@ -53,6 +55,8 @@ MergedTransaction::merge(TransactionPtr trans)
     if (!inserted) {
         transactions.push_back(trans);
     }
+    loadedItems.clear();
+    itemsLoaded = false;
 }
 
 /**
@@ -218,7 +222,7 @@ MergedTransaction::getItems()
 
     // iterate over transaction
     for (auto t : transactions) {
-        auto transItems = t->getItems();
+        auto transItems = itemsLoaded ? loadedItems[t->getId()] : t->getItems();
         // sort transaction items by their action type - forward/backward
         // this fixes behavior of the merging algorithm in several edge cases
         std::sort(transItems.begin(), transItems.end(), transaction_item_sort_function);
@@ -241,6 +245,41 @@ MergedTransaction::getItems()
     return items;
 }
 
+/**
+ * Load items of all merged transactions with one query per item type
+ * instead of querying each transaction separately in getItems().
+ * Items are dropped again when another transaction is merged.
+ * \param conn database connection the transactions were loaded from
+ */
+void
+MergedTransaction::loadItems(SQLite3Ptr conn)
+{
+    auto fromId = transactions.front()->getId();
+    auto toId = transactions.back()->getId();
+
+    loadedItems.clear();
+    for (auto t : transactions) {
+        loadedItems[t->getId()];
+    }
+
+    auto append = [this](const std::map< int64_t, std::vector< TransactionItemPtr > > &byTransaction) {
+        for (const auto &row : byTransaction) {
+            auto it = loadedItems.find(row.first);
+            if (it == loadedItems.end()) {
+                // transaction in the range that is not merged
+                continue;
+            }
+            it->second.insert(it->second.end(), row.second.begin(), row.second.end());
+        }
+    };
+
+    // keep the order of Transaction::getItems(): rpms, groups, environments
+    append(RPMItem::getTransactionItemsInRange(conn, fromId, toId));
+    append(CompsGroupItem::getTransactionItemsInRange(conn, fromId, toId));
+    append(CompsEnvironmentItem::getTransactionItemsInRange(conn, fromId, toId));
+    itemsLoaded = true;
+}
+
 static std::string
 getItemIdentifier(ItemPtr item)
 {
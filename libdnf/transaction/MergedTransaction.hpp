@@ -58,10 +58,15 @@ public:
     std::vector< std::pair< int, std::string > > getConsoleOutput();
 
     std::vector< TransactionItemBasePtr > getItems();
+    void loadItems(SQLite3Ptr conn);
 
 protected:
     std::vector< TransactionPtr > transactions;
 
+    // items of all merged transactions by transaction ID, filled by loadItems()
+    std::map< int64_t, std::vector< TransactionItemPtr > > loadedItems;
+    bool itemsLoaded = false;
+
     struct ItemPair {
         ItemPair(TransactionItemBasePtr first, TransactionItemBasePtr second)
           : first{first}
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <sstream>
 
 #include "../hy-subject.h"
@@ -64,7 +65,7 @@ RPMItem::dbSelect(int64_t pk)
         "  rpm "
         "WHERE "
         "  item_id = ?";
-    SQLite3::Statement query(*conn.get(), sql);
+    SQLite3::Statement query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(pk);
     query.step();
 
@@ -87,7 +88,7 @@ RPMItem::dbInsert()
         "  rpm "
         "VALUES "
         "  (?, ?, ?, ?, ?, ?)";
-    SQLite3::Statement query(*conn.get(), sql);
+    SQLite3::Statement query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(getId(), getName(), getEpoch(), getVersion(), getRelease(), getArch());
     query.step();
 }
@@ -141,7 +142,7 @@ RPMItem::getTransactionItems(SQLite3Ptr conn, int64_t transaction_id)
         "  ti.trans_id = ? "
         "  AND ti.repo_id = r.id "
         "  AND ti.item_id = i.item_id";
-    SQLite3::Query query(*conn.get(), sql);
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(transaction_id);
 
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
@@ -150,6 +151,54 @@ RPMItem::getTransactionItems(SQLite3Ptr conn, int64_t transaction_id)
     return result;
 }
 
+/**
+ * Load transaction items of all transactions with IDs from fromId to toId.
+ * Items of each transaction are in the same order as from getTransactionItems().
+ * \return transaction items by transaction ID
+ */
+std::map< int64_t, std::vector< TransactionItemPtr > >
+RPMItem::getTransactionItemsInRange(SQLite3Ptr conn, int64_t fromId, int64_t toId)
+{
+    std::map< int64_t, std::vector< TransactionItemPtr > > result;
+
+    const char *sql =
+        "SELECT "
+        // trans_item
+        "  ti.trans_id, "
+        "  ti.id, "
+        "  ti.action, "
+        "  ti.reason, "
+        "  ti.state, "
+        // repo
+        "  r.repoid, "
+        // rpm
+        "  i.item_id, "
+        "  i.name, "
+        "  i.epoch, "
+        "  i.version, "
+        "  i.release, "
+        "  i.arch "
+        "FROM "
+        "  trans_item ti, "
+        "  repo r, "
+        "  rpm i "
+        "WHERE "
+        "  ti.trans_id BETWEEN ? AND ? "
+        "  AND ti.repo_id = r.id "
+        "  AND ti.item_id = i.item_id "
+        "ORDER BY "
+        "  ti.trans_id, "
+        "  ti.id";
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
+    query.bindv(fromId, toId);
+
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        auto transID = query.get< int64_t >("trans_id");
+        result[transID].push_back(transactionItemFromQuery(conn, query, transID));
+    }
+    return result;
+}
+
 std::string
 RPMItem::getNEVRA() const
 {
@@ -181,7 +230,7 @@ RPMItem::dbSelectOrInsert()
         "  AND release = ? "
         "  AND arch = ?";
 
-    SQLite3::Statement query(*conn.get(), sql);
+    SQLite3::Statement query(*conn.get(), sql, SQLite3::Cached{});
 
     query.bindv(getName(), getEpoch(), getVersion(), getRelease(), getArch());
     SQLite3::Statement::StepResult result = query.step();
@@ -237,7 +286,7 @@ RPMItem::getTransactionItem(SQLite3Ptr conn, const std::string &nevra)
            ti.id DESC
         LIMIT 1
     )**";
-    SQLite3::Query query(*conn, sql);
+    SQLite3::Query query(*conn, sql, SQLite3::Cached{});
     query.bindv(nevraObject.getName(),
                 nevraObject.getEpoch(),
                 nevraObject.getVersion(),
@@ -313,7 +362,7 @@ RPMItem::resolveTransactionItemReason(SQLite3Ptr conn,
                 name = ?
         )**";
 
-        SQLite3::Query arch_query(*conn, arch_sql);
+        SQLite3::Query arch_query(*conn, arch_sql, SQLite3::Cached{});
         arch_query.bindv(name);
 
         TransactionItemReason result = TransactionItemReason::UNKNOWN;
@@ -379,32 +428,64 @@ RPMItem::searchTransactions(SQLite3Ptr conn, const std::vector< std::string > &p
 {
     std::vector< int64_t > result;
 
-    const char *sql = R"**(
+    // Each alternative is a separate select so it can be resolved through its own index on rpm.
+    // A glob with a literal prefix is turned into an index range, only a glob starting
+    // with a wildcard scans the indexes.
+    const char *sqlExact = R"**(
         SELECT DISTINCT
-            t.id
+            ti.trans_id
         FROM
-            trans t
+            trans_item ti
         JOIN
-            trans_item ti ON ti.trans_id = t.id
+            trans t ON t.id = ti.trans_id
+        WHERE
+            t.state = 1
+            AND ti.item_id IN (
+                SELECT item_id FROM rpm WHERE name = ?
+                UNION SELECT item_id FROM rpm WHERE epoch = ?
+                UNION SELECT item_id FROM rpm WHERE version = ?
+                UNION SELECT item_id FROM rpm WHERE release = ?
+                UNION SELECT item_id FROM rpm WHERE arch = ?
+            )
+    )**";
+    const char *sqlGlob = R"**(
+        SELECT DISTINCT
+            ti.trans_id
+        FROM
+            trans_item ti
         JOIN
-            rpm i USING (item_id)
+            trans t ON t.id = ti.trans_id
         WHERE
             t.state = 1
-            AND (
-                i.name = ?
-                OR i.epoch = ?
-                OR i.version = ?
-                OR i.release = ?
-                OR i.arch = ?
+            AND ti.item_id IN (
+                SELECT item_id FROM rpm WHERE name GLOB ?
+                UNION SELECT item_id FROM rpm WHERE epoch GLOB ?
+                UNION SELECT item_id FROM rpm WHERE version GLOB ?
+                UNION SELECT item_id FROM rpm WHERE release GLOB ?
+                UNION SELECT item_id FROM rpm WHERE arch GLOB ?
             )
-        ORDER BY
-           trans_id DESC
     )**";
-    SQLite3::Query query(*conn, sql);
-    for (auto pattern : patterns) {
-        query.bindv(pattern, pattern, pattern, pattern, pattern);
-        while (query.step() == SQLite3::Statement::StepResult::ROW) {
-            result.push_back(query.get< int64_t >("id"));
+    std::unique_ptr< SQLite3::Query > exactQuery;
+    std::unique_ptr< SQLite3::Query > globQuery;
+    for (const auto & pattern : patterns) {
+        SQLite3::Query * query;
+        if (pattern.find_first_of("*?[") == std::string::npos) {
+            if (!exactQuery) {
+                exactQuery.reset(new SQLite3::Query(*conn, sqlExact));
+            }
+            query = exactQuery.get();
+            query->reset();
+            query->bindv(pattern, pattern, pattern, pattern, pattern);
+        } else {
+            if (!globQuery) {
+                globQuery.reset(new SQLite3::Query(*conn, sqlGlob));
+            }
+            query = globQuery.get();
+            query->reset();
+            query->bindv(pattern, pattern, pattern, pattern, pattern);
+        }
+        while (query->step() == SQLite3::Statement::StepResult::ROW) {
+            result.push_back(query->get< int64_t >("trans_id"));
         }
     }
     std::sort(result.begin(), result.end());
@@ -18,7 +18,9 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <algorithm>
 #include <cstdio>
+#include <set>
 #include <solv/bitmap.h>
 #include <solv/solvable.h>
 
@@ -315,7 +317,7 @@ Swdb::getRPMRepo(const std::string &nevra)
         LIMIT 1;
     )**";
     // TODO: where trans.done != 0
-    SQLite3::Query query(*conn, sql);
+    SQLite3::Query query(*conn, sql, SQLite3::Cached{});
     query.bindv(nevraObject.getName(),
                 nevraObject.getEpoch(),
                 nevraObject.getVersion(),
@@ -346,7 +348,7 @@ Swdb::getLastTransaction()
             id DESC
         LIMIT 1
     )**";
-    SQLite3::Statement query(*conn, sql);
+    SQLite3::Statement query(*conn, sql, SQLite3::Cached{});
     if (query.step() == SQLite3::Statement::StepResult::ROW) {
         auto transId = query.get< int64_t >(0);
         auto transaction = std::make_shared< Transaction >(conn, transId);
@@ -366,7 +368,7 @@ Swdb::listTransactions()
         ORDER BY
             id
     )**";
-    SQLite3::Statement query(*conn, sql);
+    SQLite3::Statement query(*conn, sql, SQLite3::Cached{});
     std::vector< TransactionPtr > result;
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
         auto transId = query.get< int64_t >(0);
@@ -376,6 +378,41 @@ Swdb::listTransactions()
     return result;
 }
 
+/**
+ * Merge all transactions with IDs from fromId to toId.
+ * Items of the transactions are loaded at once for the whole range.
+ * \return merged transaction or nullptr if there is no transaction in the range
+ */
+MergedTransactionPtr
+Swdb::getMergedTransaction(int64_t fromId, int64_t toId)
+{
+    const char *sql = R"**(
+        SELECT
+            id
+        FROM
+            trans
+        WHERE
+            id BETWEEN ? AND ?
+        ORDER BY
+            id
+    )**";
+    SQLite3::Query query(*conn, sql, SQLite3::Cached{});
+    query.bindv(fromId, toId);
+    MergedTransactionPtr result;
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        auto transaction = std::make_shared< Transaction >(conn, query.get< int64_t >(0));
+        if (result) {
+            result->merge(transaction);
+        } else {
+            result = std::make_shared< MergedTransaction >(transaction);
+        }
+    }
+    if (result) {
+        result->loadItems(conn);
+    }
+    return result;
+}
+
 void
 Swdb::setReleasever(std::string value)
 {
@@ -410,73 +447,103 @@ Swdb::getCompsGroupItemsByPattern(const std::string &pattern)
 std::vector< std::string >
 Swdb::getPackageCompsGroups(const std::string &packageName)
 {
-    const char *sql_all_groups = R"**(
-        SELECT DISTINCT
-            g.groupid
-        FROM
-            comps_group g
-        JOIN
-            comps_group_package p ON p.group_id = g.item_id
-        WHERE
-            p.name = ?
-            AND p.installed = 1
-        ORDER BY
-            g.groupid
-    )**";
+    auto groups = getPackagesCompsGroups({packageName});
+    auto it = groups.find(packageName);
+    if (it == groups.end()) {
+        return {};
+    }
+    return std::move(it->second);
+}
 
-    const char *sql_trans_items = R"**(
+/// Package names are bound in chunks below the default SQLITE_MAX_VARIABLE_NUMBER
+static constexpr std::size_t NAMES_PER_QUERY = 500;
+
+static std::string
+placeholders(std::size_t count)
+{
+    std::string result;
+    for (std::size_t i = 0; i < count; ++i) {
+        result += i ? ", ?" : "?";
+    }
+    return result;
+}
+
+std::map< std::string, std::vector< std::string > >
+Swdb::getPackagesCompsGroups(const std::vector< std::string > &packageNames)
+{
+    // groups with the package installed, kept only when the group's latest transaction item
+    // does not remove it and still has some packages installed
+    const char *sql_candidates = R"**(
+        WITH candidate AS (
+            SELECT DISTINCT
+                p.name AS name,
+                g.groupid AS groupid
+            FROM
+                comps_group_package p
+            JOIN
+                comps_group g ON g.item_id = p.group_id
+            WHERE
+                p.installed = 1
+                AND p.name IN ()**";
+
+    const char *sql_latest = R"**()
+        )
         SELECT
-            ti.action as action,
-            ti.reason as reason,
-            i.item_id as group_id
+            c.name AS name,
+            c.groupid AS groupid
         FROM
-            trans_item ti
+            candidate c
         JOIN
-            comps_group i USING (item_id)
-        JOIN
-            trans t ON ti.trans_id = t.id
+            trans_item ti ON ti.id = (
+                SELECT
+                    lti.id
+                FROM
+                    trans_item lti
+                JOIN
+                    comps_group i USING (item_id)
+                JOIN
+                    trans t ON lti.trans_id = t.id
+                WHERE
+                    t.state = 1
+                    AND lti.action not in (3, 5, 7)
+                    AND i.groupid = c.groupid
+                ORDER BY
+                    lti.trans_id DESC
+                LIMIT 1
+            )
         WHERE
-            t.state = 1
-            AND ti.action not in (3, 5, 7)
-            AND i.groupid = ?
+            ti.action != ?
+            AND EXISTS (
+                SELECT
+                    1
+                FROM
+                    comps_group_package p
+                WHERE
+                    p.group_id = ti.item_id
+                    AND p.installed = 1
+            )
         ORDER BY
-            ti.trans_id DESC
-        LIMIT 1
+            c.name,
+            c.groupid
     )**";
 
-    const char *sql_group_package = R"**(
-        SELECT
-            p.name
-        FROM
-            comps_group_package p
-        WHERE
-            p.group_id = ?
-            AND p.installed = 1
-    )**";
-
-    std::vector< std::string > result;
-
-    // list all relevant groups
-    SQLite3::Query query_all_groups(*conn, sql_all_groups);
-    query_all_groups.bindv(packageName);
-
-    while (query_all_groups.step() == SQLite3::Statement::StepResult::ROW) {
-        auto groupid = query_all_groups.get< std::string >("groupid");
-        SQLite3::Query query_trans_items(*conn, sql_trans_items);
-        query_trans_items.bindv(groupid);
-        if (query_trans_items.step() == SQLite3::Statement::StepResult::ROW) {
-            auto action =
-                static_cast< TransactionItemAction >(query_trans_items.get< int64_t >("action"));
-            // if the last record is group removal, skip
-            if (action == TransactionItemAction::REMOVE) {
-                continue;
-            }
-            auto groupId = query_trans_items.get< int64_t >("group_id");
-            SQLite3::Query query_group_package(*conn, sql_group_package);
-            query_group_package.bindv(groupId);
-            if (query_group_package.step() == SQLite3::Statement::StepResult::ROW) {
-                result.push_back(groupid);
-            }
+    // a name repeated in different chunks would get its groups twice
+    std::set< std::string > uniqueNames(packageNames.begin(), packageNames.end());
+    std::vector< std::string > names(uniqueNames.begin(), uniqueNames.end());
+
+    std::map< std::string, std::vector< std::string > > result;
+    for (std::size_t begin = 0; begin < names.size(); begin += NAMES_PER_QUERY) {
+        auto end = std::min(begin + NAMES_PER_QUERY, names.size());
+        SQLite3::Query query(
+            *conn, sql_candidates + placeholders(end - begin) + sql_latest);
+        int pos = 0;
+        for (auto i = begin; i < end; ++i) {
+            query.bind(++pos, names[i]);
+        }
+        query.bind(++pos, static_cast< int >(TransactionItemAction::REMOVE));
+        while (query.step() == SQLite3::Statement::StepResult::ROW) {
+            result[query.get< std::string >("name")].push_back(
+                query.get< std::string >("groupid"));
         }
     }
     return result;
@@ -485,74 +552,62 @@ Swdb::getPackageCompsGroups(const std::string &packageName)
 std::vector< std::string >
 Swdb::getCompsGroupEnvironments(const std::string &groupId)
 {
-    const char *sql_all_environments = R"**(
-        SELECT DISTINCT
-            e.environmentid
-        FROM
-            comps_environment e
-        JOIN
-            comps_environment_group g ON g.environment_id = e.item_id
-        WHERE
-            g.groupid = ?
-            AND g.installed = 1
-        ORDER BY
-            e.environmentid
-    )**";
-
-    const char *sql_trans_items = R"**(
+    // environments with the group installed, kept only when the environment's latest
+    // transaction item does not remove it and still has some groups installed
+    const char *sql = R"**(
+        WITH candidate AS (
+            SELECT DISTINCT
+                e.environmentid AS environmentid
+            FROM
+                comps_environment_group g
+            JOIN
+                comps_environment e ON e.item_id = g.environment_id
+            WHERE
+                g.groupid = ?
+                AND g.installed = 1
+        )
         SELECT
-            ti.action as action,
-            ti.reason as reason,
-            i.item_id as environment_id
+            c.environmentid AS environmentid
         FROM
-            trans_item ti
-        JOIN
-            comps_environment i USING (item_id)
+            candidate c
         JOIN
-            trans t ON ti.trans_id = t.id
+            trans_item ti ON ti.id = (
+                SELECT
+                    lti.id
+                FROM
+                    trans_item lti
+                JOIN
+                    comps_environment i USING (item_id)
+                JOIN
+                    trans t ON lti.trans_id = t.id
+                WHERE
+                    t.state = 1
+                    AND lti.action not in (3, 5, 7)
+                    AND i.environmentid = c.environmentid
+                ORDER BY
+                    lti.trans_id DESC
+                LIMIT 1
+            )
         WHERE
-            t.state = 1
-            AND ti.action not in (3, 5, 7)
-            AND i.environmentid = ?
+            ti.action != ?
+            AND EXISTS (
+                SELECT
+                    1
+                FROM
+                    comps_environment_group g
+                WHERE
+                    g.environment_id = ti.item_id
+                    AND g.installed = 1
+            )
         ORDER BY
-            ti.trans_id DESC
-        LIMIT 1
-    )**";
-
-    const char *sql_environment_group = R"**(
-        SELECT
-            g.groupid
-        FROM
-            comps_environment_group g
-        WHERE
-            g.environment_id = ?
-            AND g.installed = 1
+            c.environmentid
     )**";
 
     std::vector< std::string > result;
-
-    // list all relevant groups
-    SQLite3::Query query_all_environments(*conn, sql_all_environments);
-    query_all_environments.bindv(groupId);
-
-    while (query_all_environments.step() == SQLite3::Statement::StepResult::ROW) {
-        auto envid = query_all_environments.get< std::string >("environmentid");
-        SQLite3::Query query_trans_items(*conn, sql_trans_items);
-        query_trans_items.bindv(envid);
-        if (query_trans_items.step() == SQLite3::Statement::StepResult::ROW) {
-            auto action =
-                static_cast< TransactionItemAction >(query_trans_items.get< int64_t >("action"));
-            // if the last record is group removal, skip
-            if (action == TransactionItemAction::REMOVE) {
-                continue;
-            }
-            auto envId = query_trans_items.get< int64_t >("environment_id");
-            SQLite3::Query query_environment_group(*conn, sql_environment_group);
-            query_environment_group.bindv(envId);
-            if (query_environment_group.step() == SQLite3::Statement::StepResult::ROW) {
-                result.push_back(envid);
-            }
-        }
+    SQLite3::Query query(*conn, sql, SQLite3::Cached{});
+    query.bindv(groupId, static_cast< int >(TransactionItemAction::REMOVE));
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        result.push_back(query.get< std::string >("environmentid"));
     }
     return result;
 }
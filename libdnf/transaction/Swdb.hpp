@@ -38,6 +38,7 @@ class Transformer;
 #include "../utils/sqlite3/Sqlite3.hpp"
 
 #include "CompsGroupItem.hpp"
+#include "MergedTransaction.hpp"
 #include "Transaction.hpp"
 #include "TransactionItem.hpp"
 #include "private/Transaction.hpp"
@@ -76,6 +77,7 @@ public:
     TransactionPtr getLastTransaction();
     std::vector< TransactionPtr >
     listTransactions(); // std::vector<long long> transactionIds);
+    MergedTransactionPtr getMergedTransaction(int64_t fromId, int64_t toId);
 
     TransactionPtr getCurrent() { return std::dynamic_pointer_cast<Transaction>(transactionInProgress); }
 
@@ -106,6 +108,10 @@ public:
     TransactionItemPtr getCompsGroupItem(const std::string &groupid);
     std::vector< TransactionItemPtr > getCompsGroupItemsByPattern(const std::string &pattern);
     std::vector< std::string > getPackageCompsGroups(const std::string &packageName);
+    /// Same as getPackageCompsGroups() for many packages at once,
+    /// packages without any group are missing in the result
+    std::map< std::string, std::vector< std::string > >
+    getPackagesCompsGroups(const std::vector< std::string > &packageNames);
 
     // Item: CompsEnvironment
     TransactionItemPtr getCompsEnvironmentItem(const std::string &envid);
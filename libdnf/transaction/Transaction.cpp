@@ -88,7 +88,7 @@ Transaction::dbSelect(int64_t pk)
         "  trans "
         "WHERE "
         "  id = ?";
-    SQLite3::Query query(*conn.get(), sql);
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(pk);
     query.step();
 
@@ -143,7 +143,7 @@ Transaction::getSoftwarePerformedWith() const
 
     std::set< std::shared_ptr< RPMItem > > software;
 
-    SQLite3::Query query(*conn.get(), sql);
+    SQLite3::Query query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(getId());
 
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
@@ -167,7 +167,7 @@ Transaction::getConsoleOutput() const
         ORDER BY
             id
     )**";
-    SQLite3::Query query(*conn, sql);
+    SQLite3::Query query(*conn, sql, SQLite3::Cached{});
     query.bindv(getId());
     std::vector< std::pair< int, std::string > > result;
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
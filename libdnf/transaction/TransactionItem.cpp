@@ -162,7 +162,7 @@ TransactionItem::dbInsert()
     )**";
 
     // save the transaction item
-    SQLite3::Statement query(*(conn.get()), sql);
+    SQLite3::Statement query(*(conn.get()), sql, SQLite3::Cached{});
     query.bindv(trans->getId(),
                 getItem()->getId(),
                 swdb_private::Repo::getCached(conn, getRepoid())->getId(),
@@ -180,7 +180,7 @@ TransactionItem::saveReplacedBy()
         return;
     }
     const char *sql = "INSERT OR REPLACE INTO item_replaced_by VALUES (?, ?)";
-    SQLite3::Statement replacedByQuery(*(conn.get()), sql);
+    SQLite3::Statement replacedByQuery(*(conn.get()), sql, SQLite3::Cached{});
     bool first = true;
     for (const auto &newItem : replacedBy) {
         if (!first) {
@@ -205,7 +205,7 @@ TransactionItem::saveState()
           id = ?
     )**";
 
-    SQLite3::Statement query(*conn, sql);
+    SQLite3::Statement query(*conn, sql, SQLite3::Cached{});
     query.bindv(static_cast< int >(getState()), getId());
     query.step();
 }
@@ -231,7 +231,7 @@ TransactionItem::dbUpdate()
           id = ?
     )**";
 
-    SQLite3::Statement query(*(conn.get()), sql);
+    SQLite3::Statement query(*(conn.get()), sql, SQLite3::Cached{});
     query.bindv(trans->getId(),
                 getItem()->getId(),
                 swdb_private::Repo::getCached(trans->conn, getRepoid())->getId(),
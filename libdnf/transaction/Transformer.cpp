@@ -19,17 +19,22 @@
  */
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <deque>
 #include <dirent.h>
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <map>
+#include <thread>
 #include <vector>
 #include <sstream>
 
@@ -45,6 +50,8 @@
 
 namespace libdnf {
 
+constexpr std::size_t Transformer::HISTORY_QUEUE_SIZE;
+
 static const char *sql_create_tables =
 #include "sql/create_tables.sql"
     ;
@@ -53,6 +60,14 @@ static const char * const sql_migrate_tables_1_2 =
 #include "sql/migrate_tables_1_2.sql"
     ;
 
+static const char * const sql_migrate_tables_1_3 =
+#include "sql/migrate_tables_1_3.sql"
+    ;
+
+static const char * const sql_migrate_tables_1_4 =
+#include "sql/migrate_tables_1_4.sql"
+    ;
+
 void
 Transformer::createDatabase(SQLite3Ptr conn)
 {
@@ -70,6 +85,14 @@ Transformer::migrateSchema(SQLite3Ptr conn)
 
         if (schemaVersion == "1.1") {
             conn->exec(sql_migrate_tables_1_2);
+            schemaVersion = "1.2";
+        }
+        if (schemaVersion == "1.2") {
+            conn->exec(sql_migrate_tables_1_3);
+            schemaVersion = "1.3";
+        }
+        if (schemaVersion == "1.3") {
+            conn->exec(sql_migrate_tables_1_4);
         }
     }
     else {
@@ -175,107 +198,275 @@ Transformer::transform()
 }
 
 /**
- * Transform transactions from the history database
+ * Package row loaded from the history database
+ */
+struct Transformer::HistoryPackage {
+    std::string name;
+    int64_t epoch;
+    std::string version;
+    std::string release;
+    std::string arch;
+
+    // following members are used only for transaction packages
+    std::string state;
+    bool done = false;
+    TransactionItemReason reason = TransactionItemReason::UNKNOWN;
+    std::string repoid;
+};
+
+/**
+ * Transaction loaded from the history database with all its rows,
+ * which is enough to write it to swdb without touching the history database again
+ */
+struct Transformer::HistoryTransaction {
+    int64_t id;
+    int64_t dtBegin;
+    int64_t dtEnd;
+    std::string rpmdbVersionBegin;
+    std::string rpmdbVersionEnd;
+    std::string releasever;
+    bool hasReleasever = false;
+    uint32_t userId;
+    std::string cmdline;
+    int returnCode;
+
+    std::vector< HistoryPackage > packages;
+    std::vector< HistoryPackage > performedWith;
+    std::vector< std::pair< int, std::string > > output;
+};
+
+/**
+ * Bounded queue passing transactions from the history reader thread to the swdb writer.
+ * The reader blocks when the writer falls behind, the writer blocks until a transaction
+ * is read or the reader is done.
+ */
+class Transformer::HistoryQueue {
+public:
+    explicit HistoryQueue(std::size_t capacity)
+      : capacity{capacity}
+    {
+    }
+
+    /**
+     * Add a transaction to the queue, wait while the queue is full.
+     * \return false if the writer cancelled the migration
+     */
+    bool push(std::unique_ptr< HistoryTransaction > trans)
+    {
+        std::unique_lock< std::mutex > lock(mutex);
+        notFull.wait(lock, [this] { return cancelled || items.size() < capacity; });
+        if (cancelled) {
+            return false;
+        }
+        items.push_back(std::move(trans));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * Take the next transaction from the queue, wait while the queue is empty.
+     * \return nullptr once the reader is done and the queue is drained
+     */
+    std::unique_ptr< HistoryTransaction > pop()
+    {
+        std::unique_lock< std::mutex > lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return nullptr;
+        }
+        auto trans = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return trans;
+    }
+
+    /// Called by the reader when there are no more transactions or reading failed
+    void close(std::exception_ptr readError = nullptr)
+    {
+        std::lock_guard< std::mutex > lock(mutex);
+        closed = true;
+        error = readError;
+        notEmpty.notify_one();
+    }
+
+    /// Called by the writer to stop the reader
+    void cancel()
+    {
+        std::lock_guard< std::mutex > lock(mutex);
+        cancelled = true;
+        notFull.notify_one();
+    }
+
+    std::exception_ptr getError()
+    {
+        std::lock_guard< std::mutex > lock(mutex);
+        return error;
+    }
+
+private:
+    const std::size_t capacity;
+    std::deque< std::unique_ptr< HistoryTransaction > > items;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    bool closed = false;
+    bool cancelled = false;
+    std::exception_ptr error;
+};
+
+/**
+ * Transform transactions from the history database.
+ * The history database is read in a separate thread while the transactions
+ * are written to swdb within a single SQL transaction.
  * \param swdb pointer to swdb SQLite3 object
  * \param swdb pointer to history database SQLite3 object
  */
 void
 Transformer::transformTrans(SQLite3Ptr swdb, SQLite3Ptr history)
 {
-    std::vector< std::shared_ptr< TransformerTransaction > > result;
+    HistoryQueue queue(HISTORY_QUEUE_SIZE);
 
-    // we need to left join with trans_cmdline
-    // there is no cmdline for certain transactions (e.g. 1)
-    const char *trans_sql = R"**(
-        SELECT
-            tb.tid as id,
-            tb.timestamp as dt_begin,
-            tb.rpmdb_version rpmdb_version_begin,
-            tb.loginuid as user_id,
-            te.timestamp as dt_end,
-            te.rpmdb_version as rpmdb_version_end,
-            te.return_code as state,
-            tc.cmdline as cmdline
-        FROM
-            trans_beg tb
-            JOIN trans_end te using(tid)
-            LEFT JOIN trans_cmdline tc using(tid)
-        ORDER BY
-            tb.tid
-    )**";
-
-    const char *releasever_sql = R"**(
-        SELECT DISTINCT
-            trans_data_pkgs.tid as tid,
-            yumdb_val as releasever
-        FROM
-            trans_data_pkgs
-        JOIN
-            pkg_yumdb USING (pkgtupid)
-        WHERE
-            yumdb_key='releasever'
-    )**";
+    // begin before the reader is started, a failure leaves no thread to join
+    swdb->exec("BEGIN TRANSACTION;");
 
-    // get release version for all the transactions
-    std::map< int64_t, std::string > releasever;
-    SQLite3::Query releasever_query(*history.get(), releasever_sql);
-    while (releasever_query.step() == SQLite3::Statement::StepResult::ROW) {
-        std::string releaseVerStr = releasever_query.get< std::string >("releasever");
-        releasever[releasever_query.get< int64_t >("tid")] = releaseVerStr;
+    // the history connection is used only by the reader thread from now on
+    std::thread reader;
+    try {
+        reader = std::thread([history, &queue] {
+            try {
+                readHistory(history, queue);
+                queue.close();
+            } catch (...) {
+                queue.close(std::current_exception());
+            }
+        });
+    } catch (...) {
+        swdb->exec("ROLLBACK;");
+        throw;
     }
 
-    // iterate over history transactions
-    SQLite3::Query query(*history.get(), trans_sql);
-    while (query.step() == SQLite3::Statement::StepResult::ROW) {
-        auto trans = std::make_shared< TransformerTransaction >(swdb);
-        trans->setId(query.get< int >("id"));
-        trans->setDtBegin(query.get< int64_t >("dt_begin"));
-        trans->setDtEnd(query.get< int64_t >("dt_end"));
-        trans->setRpmdbVersionBegin(query.get< std::string >("rpmdb_version_begin"));
-        trans->setRpmdbVersionEnd(query.get< std::string >("rpmdb_version_end"));
-
-        // set release version if available
-        auto it = releasever.find(trans->getId());
-        if (it != releasever.end()) {
-            trans->setReleasever(it->second);
-        }
+    try {
+        while (auto source = queue.pop()) {
+            auto trans = std::make_shared< TransformerTransaction >(swdb);
+            trans->setId(source->id);
+            trans->setDtBegin(source->dtBegin);
+            trans->setDtEnd(source->dtEnd);
+            trans->setRpmdbVersionBegin(source->rpmdbVersionBegin);
+            trans->setRpmdbVersionEnd(source->rpmdbVersionEnd);
+
+            // set release version if available
+            if (source->hasReleasever) {
+                trans->setReleasever(source->releasever);
+            }
 
-        trans->setUserId(query.get< int >("user_id"));
-        trans->setCmdline(query.get< std::string >("cmdline"));
+            trans->setUserId(source->userId);
+            trans->setCmdline(source->cmdline);
 
-        TransactionState state = query.get< int >("state") == 0 ? TransactionState::DONE : TransactionState::ERROR;
+            TransactionState state = source->returnCode == 0 ? TransactionState::DONE : TransactionState::ERROR;
 
-        transformRPMItems(swdb, history, trans);
-        transformTransWith(swdb, history, trans);
+            transformRPMItems(swdb, *source, trans);
+            transformTransWith(swdb, *source, trans);
 
-        trans->begin();
+            trans->begin();
 
-        transformOutput(history, trans);
+            transformOutput(*source, trans);
+
+            trans->finish(state);
+        }
+    } catch (...) {
+        queue.cancel();
+        reader.join();
+        swdb->exec("ROLLBACK;");
+        throw;
+    }
+    reader.join();
 
-        trans->finish(state);
+    auto readError = queue.getError();
+    if (readError) {
+        swdb->exec("ROLLBACK;");
+        std::rethrow_exception(readError);
     }
+    swdb->exec("COMMIT;");
+}
+
+void
+Transformer::fillHistoryPackage(HistoryPackage &pkg, SQLite3::Query &query)
+{
+    pkg.name = query.get< std::string >("name");
+    pkg.epoch = query.get< int64_t >("epoch");
+    pkg.version = query.get< std::string >("version");
+    pkg.release = query.get< std::string >("release");
+    pkg.arch = query.get< std::string >("arch");
 }
 
 static void
-fillRPMItem(std::shared_ptr< RPMItem > rpm, SQLite3::Query &query)
+getYumdbData(int64_t itemId, SQLite3Ptr history, TransactionItemReason &reason, std::string &repoid)
 {
-    rpm->setName(query.get< std::string >("name"));
-    rpm->setEpoch(query.get< int64_t >("epoch"));
-    rpm->setVersion(query.get< std::string >("version"));
-    rpm->setRelease(query.get< std::string >("release"));
-    rpm->setArch(query.get< std::string >("arch"));
-    rpm->save();
+    const char *sql = R"**(
+        SELECT
+            yumdb_key as key,
+            yumdb_val as value
+        FROM
+            pkg_yumdb
+        WHERE
+            pkgtupid=?
+            and key IN ('reason', 'from_repo')
+    )**";
+
+    // load reason and repoid data from yumdb
+    SQLite3::Query query(*history.get(), sql, SQLite3::Cached{});
+    query.bindv(itemId);
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        std::string key = query.get< std::string >("key");
+        if (key == "reason") {
+            reason = Transformer::getReason(query.get< std::string >("value"));
+        } else if (key == "from_repo") {
+            repoid = query.get< std::string >("value");
+        }
+    }
 }
 
 /**
- * Transform binding between a Transaction and packages, which performed the transaction.
- * \param swdb pointer to swdb SQLite3 object
- * \param swdb pointer to history database SQLite3 object
+ * Load packages of a particular transaction from the history database.
  */
 void
-Transformer::transformTransWith(SQLite3Ptr swdb,
-                                SQLite3Ptr history,
-                                std::shared_ptr< TransformerTransaction > trans)
+Transformer::readHistoryPackages(SQLite3Ptr history, HistoryTransaction &trans)
+{
+    // the order is important here - its Update, Updated
+    const char *pkg_sql = R"**(
+        SELECT
+            t.state,
+            t.done,
+            r.pkgtupid as id,
+            r.name,
+            r.epoch,
+            r.version,
+            r.release,
+            r.arch
+        FROM
+            trans_data_pkgs t
+            JOIN pkgtups r using(pkgtupid)
+        WHERE
+            t.tid=?
+    )**";
+
+    SQLite3::Query query(*history.get(), pkg_sql, SQLite3::Cached{});
+    query.bindv(trans.id);
+    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+        HistoryPackage pkg;
+        fillHistoryPackage(pkg, query);
+        pkg.state = query.get< std::string >("state");
+        pkg.done = query.get< std::string >("done") == "TRUE";
+        getYumdbData(query.get< int64_t >("id"), history, pkg.reason, pkg.repoid);
+        trans.packages.push_back(std::move(pkg));
+    }
+}
+
+/**
+ * Load packages, which performed a particular transaction, from the history database.
+ */
+void
+Transformer::readHistoryTransWith(SQLite3Ptr history, HistoryTransaction &trans)
 {
     const char *sql = R"**(
         SELECT
@@ -291,23 +482,20 @@ Transformer::transformTransWith(SQLite3Ptr swdb,
             tid=?
     )**";
 
-    // transform stdout
-    SQLite3::Query query(*history.get(), sql);
-    query.bindv(trans->getId());
+    SQLite3::Query query(*history.get(), sql, SQLite3::Cached{});
+    query.bindv(trans.id);
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
-        // create RPM item object
-        auto rpm = std::make_shared< RPMItem >(swdb);
-        fillRPMItem(rpm, query);
-        trans->addSoftwarePerformedWith(rpm);
+        HistoryPackage pkg;
+        fillHistoryPackage(pkg, query);
+        trans.performedWith.push_back(std::move(pkg));
     }
 }
 
 /**
- * Transform transaction console outputs.
- * \param swdb pointer to history database SQLite3 object
+ * Load console outputs of a particular transaction from the history database.
  */
 void
-Transformer::transformOutput(SQLite3Ptr history, std::shared_ptr< TransformerTransaction > trans)
+Transformer::readHistoryOutput(SQLite3Ptr history, HistoryTransaction &trans)
 {
     const char *sql = R"**(
         SELECT
@@ -320,11 +508,11 @@ Transformer::transformOutput(SQLite3Ptr history, std::shared_ptr< TransformerTra
             lid
     )**";
 
-    // transform stdout
-    SQLite3::Query query(*history.get(), sql);
-    query.bindv(trans->getId());
+    // stdout
+    SQLite3::Query query(*history.get(), sql, SQLite3::Cached{});
+    query.bindv(trans.id);
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
-        trans->addConsoleOutputLine(1, query.get< std::string >("line"));
+        trans.output.emplace_back(1, query.get< std::string >("line"));
     }
 
     sql = R"**(
@@ -338,73 +526,145 @@ Transformer::transformOutput(SQLite3Ptr history, std::shared_ptr< TransformerTra
             mid
     )**";
 
-    // transform stderr
-    SQLite3::Query errorQuery(*history.get(), sql);
-    errorQuery.bindv(trans->getId());
+    // stderr
+    SQLite3::Query errorQuery(*history.get(), sql, SQLite3::Cached{});
+    errorQuery.bindv(trans.id);
     while (errorQuery.step() == SQLite3::Statement::StepResult::ROW) {
-        trans->addConsoleOutputLine(2, errorQuery.get< std::string >("msg"));
+        trans.output.emplace_back(2, errorQuery.get< std::string >("msg"));
     }
 }
 
-static void
-getYumdbData(int64_t itemId, SQLite3Ptr history, TransactionItemReason &reason, std::string &repoid)
+/**
+ * Read transactions from the history database and pass them to the queue.
+ * \param history pointer to history database SQLite3 object
+ * \param queue queue consumed by transformTrans()
+ */
+void
+Transformer::readHistory(SQLite3Ptr history, HistoryQueue &queue)
 {
-    const char *sql = R"**(
+    // we need to left join with trans_cmdline
+    // there is no cmdline for certain transactions (e.g. 1)
+    const char *trans_sql = R"**(
         SELECT
-            yumdb_key as key,
-            yumdb_val as value
+            tb.tid as id,
+            tb.timestamp as dt_begin,
+            tb.rpmdb_version rpmdb_version_begin,
+            tb.loginuid as user_id,
+            te.timestamp as dt_end,
+            te.rpmdb_version as rpmdb_version_end,
+            te.return_code as state,
+            tc.cmdline as cmdline
         FROM
-            pkg_yumdb
+            trans_beg tb
+            JOIN trans_end te using(tid)
+            LEFT JOIN trans_cmdline tc using(tid)
+        ORDER BY
+            tb.tid
+    )**";
+
+    const char *releasever_sql = R"**(
+        SELECT DISTINCT
+            trans_data_pkgs.tid as tid,
+            yumdb_val as releasever
+        FROM
+            trans_data_pkgs
+        JOIN
+            pkg_yumdb USING (pkgtupid)
         WHERE
-            pkgtupid=?
-            and key IN ('reason', 'from_repo')
+            yumdb_key='releasever'
     )**";
 
-    // load reason and repoid data from yumdb
-    SQLite3::Query query(*history.get(), sql);
-    query.bindv(itemId);
+    // get release version for all the transactions
+    std::map< int64_t, std::string > releasever;
+    SQLite3::Query releasever_query(*history.get(), releasever_sql);
+    while (releasever_query.step() == SQLite3::Statement::StepResult::ROW) {
+        std::string releaseVerStr = releasever_query.get< std::string >("releasever");
+        releasever[releasever_query.get< int64_t >("tid")] = releaseVerStr;
+    }
+
+    // iterate over history transactions
+    SQLite3::Query query(*history.get(), trans_sql);
     while (query.step() == SQLite3::Statement::StepResult::ROW) {
-        std::string key = query.get< std::string >("key");
-        if (key == "reason") {
-            reason = Transformer::getReason(query.get< std::string >("value"));
-        } else if (key == "from_repo") {
-            repoid = query.get< std::string >("value");
+        std::unique_ptr< HistoryTransaction > trans(new HistoryTransaction);
+        trans->id = query.get< int >("id");
+        trans->dtBegin = query.get< int64_t >("dt_begin");
+        trans->dtEnd = query.get< int64_t >("dt_end");
+        trans->rpmdbVersionBegin = query.get< std::string >("rpmdb_version_begin");
+        trans->rpmdbVersionEnd = query.get< std::string >("rpmdb_version_end");
+
+        auto it = releasever.find(trans->id);
+        if (it != releasever.end()) {
+            trans->releasever = it->second;
+            trans->hasReleasever = true;
+        }
+
+        trans->userId = query.get< int >("user_id");
+        trans->cmdline = query.get< std::string >("cmdline");
+        trans->returnCode = query.get< int >("state");
+
+        readHistoryPackages(history, *trans);
+        readHistoryTransWith(history, *trans);
+        readHistoryOutput(history, *trans);
+
+        if (!queue.push(std::move(trans))) {
+            return;
         }
     }
 }
 
+void
+Transformer::fillRPMItem(std::shared_ptr< RPMItem > rpm, const HistoryPackage &pkg)
+{
+    rpm->setName(pkg.name);
+    rpm->setEpoch(pkg.epoch);
+    rpm->setVersion(pkg.version);
+    rpm->setRelease(pkg.release);
+    rpm->setArch(pkg.arch);
+    rpm->save();
+}
+
+/**
+ * Transform binding between a Transaction and packages, which performed the transaction.
+ * \param swdb pointer to swdb SQLite3 object
+ * \param source transaction loaded from the history database
+ */
+void
+Transformer::transformTransWith(SQLite3Ptr swdb,
+                                const HistoryTransaction &source,
+                                std::shared_ptr< TransformerTransaction > trans)
+{
+    for (const auto &pkg : source.performedWith) {
+        // create RPM item object
+        auto rpm = std::make_shared< RPMItem >(swdb);
+        fillRPMItem(rpm, pkg);
+        trans->addSoftwarePerformedWith(rpm);
+    }
+}
+
+/**
+ * Transform transaction console outputs.
+ * \param source transaction loaded from the history database
+ */
+void
+Transformer::transformOutput(const HistoryTransaction &source,
+                             std::shared_ptr< TransformerTransaction > trans)
+{
+    for (const auto &line : source.output) {
+        trans->addConsoleOutputLine(line.first, line.second);
+    }
+}
+
 /**
  * Transform RPM Items from a particular transaction.
  * \param swdb pointer to swdb SQLite3 object
- * \param swdb pointer to history database SQLite3 objects
+ * \param source transaction loaded from the history database
  * \param trans Transaction whose items should be transformed
  */
 void
 Transformer::transformRPMItems(SQLite3Ptr swdb,
-                               SQLite3Ptr history,
+                               const HistoryTransaction &source,
                                std::shared_ptr< TransformerTransaction > trans)
 {
-    // the order is important here - its Update, Updated
-    const char *pkg_sql = R"**(
-        SELECT
-            t.state,
-            t.done,
-            r.pkgtupid as id,
-            r.name,
-            r.epoch,
-            r.version,
-            r.release,
-            r.arch
-        FROM
-            trans_data_pkgs t
-            JOIN pkgtups r using(pkgtupid)
-        WHERE
-            t.tid=?
-    )**";
-
-    SQLite3::Query query(*history.get(), pkg_sql);
-    query.bindv(trans->getId());
-
     TransactionItemPtr last = nullptr;
 
     /*
@@ -417,16 +677,15 @@ Transformer::transformRPMItems(SQLite3Ptr swdb,
      */
     std::map< int64_t, TransactionItemPtr > obsoletedItems;
 
-    // iterate over transaction packages in the history database
-    while (query.step() == SQLite3::Statement::StepResult::ROW) {
+    // iterate over transaction packages from the history database
+    for (const auto &pkg : source.packages) {
 
         // create RPM item object
         auto rpm = std::make_shared< RPMItem >(swdb);
-        fillRPMItem(rpm, query);
+        fillRPMItem(rpm, pkg);
 
         // get item state/action
-        std::string stateString = query.get< std::string >("state");
-        TransactionItemAction action = actions.at(stateString);
+        TransactionItemAction action = actions.at(pkg.state);
 
         // `Obsoleting` record is duplicated with previous record (with different action)
         if (action == TransactionItemAction::OBSOLETE) {
@@ -441,14 +700,9 @@ Transformer::transformRPMItems(SQLite3Ptr swdb,
         if (pastObsoleted == obsoletedItems.end()) {
             // item hasn't been obsoleted yet
 
-            // load reason and from_repo
-            TransactionItemReason reason = TransactionItemReason::UNKNOWN;
-            std::string repoid;
-            getYumdbData(query.get< int64_t >("id"), history, reason, repoid);
-
             // add TransactionItem object
-            transItem = trans->addItem(rpm, repoid, action, reason);
-            transItem->setState(query.get< std::string >("done") == "TRUE" ? TransactionItemState::DONE : TransactionItemState::ERROR);
+            transItem = trans->addItem(rpm, pkg.repoid, action, pkg.reason);
+            transItem->setState(pkg.done ? TransactionItemState::DONE : TransactionItemState::ERROR);
         } else {
             // item has been obsoleted - we just need to update the action
             transItem = pastObsoleted->second;
@@ -60,7 +60,7 @@ public:
     static void migrateSchema(SQLite3Ptr conn);
 
     static TransactionItemReason getReason(const std::string &reason);
-    static const char *getVersion() noexcept { return "1.2"; }
+    static const char *getVersion() noexcept { return "1.4"; }
 
 protected:
     void transformTrans(SQLite3Ptr swdb, SQLite3Ptr history);
@@ -69,12 +69,26 @@ protected:
     void processGroupPersistor(SQLite3Ptr swdb, struct json_object *root);
 
 private:
+    struct HistoryPackage;
+    struct HistoryTransaction;
+    class HistoryQueue;
+
+    /// number of transactions read ahead from the history database
+    static constexpr std::size_t HISTORY_QUEUE_SIZE = 64;
+
+    static void readHistory(SQLite3Ptr history, HistoryQueue &queue);
+    static void readHistoryPackages(SQLite3Ptr history, HistoryTransaction &trans);
+    static void readHistoryTransWith(SQLite3Ptr history, HistoryTransaction &trans);
+    static void readHistoryOutput(SQLite3Ptr history, HistoryTransaction &trans);
+    static void fillHistoryPackage(HistoryPackage &pkg, SQLite3::Query &query);
+    static void fillRPMItem(std::shared_ptr< RPMItem > rpm, const HistoryPackage &pkg);
     void transformRPMItems(SQLite3Ptr swdb,
-                           SQLite3Ptr history,
+                           const HistoryTransaction &source,
                            std::shared_ptr< TransformerTransaction > trans);
-    void transformOutput(SQLite3Ptr history, std::shared_ptr< TransformerTransaction > trans);
+    void transformOutput(const HistoryTransaction &source,
+                         std::shared_ptr< TransformerTransaction > trans);
     void transformTransWith(SQLite3Ptr swdb,
-                            SQLite3Ptr history,
+                            const HistoryTransaction &source,
                             std::shared_ptr< TransformerTransaction > trans);
     CompsGroupItemPtr processGroup(SQLite3Ptr swdb,
                                    const char *groupId,
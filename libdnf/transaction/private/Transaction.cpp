@@ -82,7 +82,7 @@ swdb_private::Transaction::dbInsert()
         "  ) "
         "VALUES "
         "  (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
-    SQLite3::Statement query(*conn.get(), sql);
+    SQLite3::Statement query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(getDtBegin(),
                 getDtEnd(),
                 getRpmdbVersionBegin(),
@@ -109,7 +109,7 @@ swdb_private::Transaction::dbInsert()
             VALUES
                 (?, ?)
         )**";
-        SQLite3::Statement swQuery(*conn.get(), sql);
+        SQLite3::Statement swQuery(*conn.get(), sql, SQLite3::Cached{});
         bool first = true;
         for (auto software : softwarePerformedWith) {
             if (!first) {
@@ -142,7 +142,7 @@ swdb_private::Transaction::dbUpdate()
         "  comment=? "
         "WHERE "
         "  id = ?";
-    SQLite3::Statement query(*conn.get(), sql);
+    SQLite3::Statement query(*conn.get(), sql, SQLite3::Cached{});
     query.bindv(getDtBegin(),
                 getDtEnd(),
                 getRpmdbVersionBegin(),
@@ -253,7 +253,7 @@ swdb_private::Transaction::addConsoleOutputLine(int fileDescriptor, const std::s
         VALUES
             (?, ?, ?);
     )**";
-    SQLite3::Statement query(*conn, sql);
+    SQLite3::Statement query(*conn, sql, SQLite3::Cached{});
     query.bindv(getId(), fileDescriptor, line);
     query.step();
 }
@@ -0,0 +1,13 @@
+R"**(
+BEGIN TRANSACTION;
+    /* covering indexes for searching transactions by package (RPMItem::searchTransactions) */
+    CREATE INDEX IF NOT EXISTS rpm_epoch ON rpm(epoch, item_id);
+    CREATE INDEX IF NOT EXISTS rpm_version ON rpm(version, item_id);
+    CREATE INDEX IF NOT EXISTS rpm_release ON rpm(release, item_id);
+    CREATE INDEX IF NOT EXISTS rpm_arch ON rpm(arch, item_id);
+    CREATE INDEX IF NOT EXISTS trans_item_item_id_trans_id ON trans_item(item_id, trans_id);
+    UPDATE config
+        SET value = '1.3'
+        WHERE key = 'version';
+COMMIT;
+)**"
@@ -0,0 +1,13 @@
+R"**(
+BEGIN TRANSACTION;
+    /* membership of packages in groups and of groups in environments
+       (Swdb::getPackageCompsGroups, Swdb::getCompsGroupEnvironments) */
+    CREATE INDEX IF NOT EXISTS comps_group_package_name_installed ON comps_group_package(name, installed);
+    CREATE INDEX IF NOT EXISTS comps_environment_group_groupid_installed ON comps_environment_group(groupid, installed);
+    CREATE INDEX IF NOT EXISTS comps_group_groupid ON comps_group(groupid);
+    CREATE INDEX IF NOT EXISTS comps_environment_environmentid ON comps_environment(environmentid);
+    UPDATE config
+        SET value = '1.4'
+        WHERE key = 'version';
+COMMIT;
+)**"
@@ -1,11 +1,13 @@
 #include "CompressedFile.hpp"
 #include <utility>
-#include <sstream>
+
+#include <sys/stat.h>
 
 extern "C" {
 #   include <solv/solv_xfopen.h>
 };
 
+#include <algorithm>
 #include <cerrno>
 #include <system_error>
 
@@ -36,21 +38,30 @@ std::string CompressedFile::getContent()
         throw NotOpenedException(filePath);
     }
 
-    constexpr size_t bufferSize = 4096;
-    char buffer[bufferSize];
-    std::ostringstream ss;
-    size_t bytesRead;
+    // The decompressed size is not known upfront, the compressed one is a lower estimate.
+    // Data are read directly into the result, without an intermediate stream and copy.
+    std::string content;
+    struct stat st;
+    if (stat(filePath.c_str(), &st) == 0) {
+        content.reserve(st.st_size);
+    }
 
+    size_t length = 0;
+    size_t bytesRead;
     do {
+        if (content.size() < length + DEFAULT_CHUNK_SIZE) {
+            content.resize(std::max(length + DEFAULT_CHUNK_SIZE, content.capacity()));
+        }
         try {
-            bytesRead = read(buffer, bufferSize);
+            bytesRead = read(&content[length], DEFAULT_CHUNK_SIZE);
         } catch (const ReadError & e) {
             throw ReadError(std::string(e.what()) + " Likely the archive is damaged.");
         }
-        ss.write(buffer, bytesRead);
-    } while (bytesRead == bufferSize);
+        length += bytesRead;
+    } while (bytesRead == DEFAULT_CHUNK_SIZE);
+    content.resize(length);
 
-    return ss.str();
+    return content;
 }
 
 }
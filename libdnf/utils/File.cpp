@@ -19,6 +19,8 @@ extern "C" {
 
 namespace libdnf {
 
+constexpr size_t File::DEFAULT_CHUNK_SIZE;
+
 std::unique_ptr<File> File::newFile(const std::string &filePath)
 {
     if (solv_xfopen_iscompressed(filePath.c_str()) == 1) {
@@ -87,6 +89,23 @@ bool File::readLine(std::string &line)
     return true;
 }
 
+void File::readChunks(const std::function<void(const char * data, size_t length)> & consumer,
+                      size_t chunkSize)
+{
+    if (!file) {
+        throw NotOpenedException(filePath);
+    }
+
+    std::unique_ptr<char[]> buffer(new char[chunkSize]);
+    size_t bytesRead;
+    do {
+        bytesRead = read(buffer.get(), chunkSize);
+        if (bytesRead > 0) {
+            consumer(buffer.get(), bytesRead);
+        }
+    } while (bytesRead == chunkSize);
+}
+
 std::string File::getContent()
 {
     if (!file) {
@@ -4,6 +4,7 @@
 #include "../error.hpp"
 
 #include <fstream>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -54,6 +55,12 @@ public:
     bool readLine(std::string &line);
     virtual std::string getContent();
 
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 256 * 1024;
+
+    /// Passes the content to the consumer chunk by chunk, without holding all of it in memory.
+    void readChunks(const std::function<void(const char * data, size_t length)> & consumer,
+                    size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
 protected:
     std::string filePath;
     FILE *file;
@@ -21,6 +21,8 @@
 
 #include "Sqlite3.hpp"
 
+constexpr std::size_t SQLite3::STATEMENT_CACHE_SIZE;
+
 void
 SQLite3::open()
 {
@@ -53,6 +55,7 @@ SQLite3::close()
 {
     if (db == nullptr)
         return;
+    clearStatementCache();
     auto result = sqlite3_close(db);
     if (result == SQLITE_BUSY) {
         sqlite3_stmt *res;
@@ -120,3 +123,58 @@ SQLite3::restore(const std::string &inputFile)
         throw Error(*this, result, "Database restore failed");
     }
 }
+
+sqlite3_stmt *
+SQLite3::acquireStatement(const std::string &sql)
+{
+    // a statement is handed out only once at a time, it is taken off the cache while in use
+    auto it = cachedStatementsBySql.find(sql);
+    if (it != cachedStatementsBySql.end()) {
+        auto stmt = it->second->second;
+        cachedStatements.erase(it->second);
+        cachedStatementsBySql.erase(it);
+        return stmt;
+    }
+
+    sqlite3_stmt *stmt;
+    auto result = sqlite3_prepare_v2(db, sql.c_str(), sql.length() + 1, &stmt, nullptr);
+    if (result != SQLITE_OK)
+        throw Error(*this, result, "Creating statement failed");
+    return stmt;
+}
+
+void
+SQLite3::releaseStatement(const std::string &sql, sqlite3_stmt *stmt)
+{
+    if (db == nullptr) {
+        sqlite3_finalize(stmt);
+        return;
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    if (cachedStatementsBySql.count(sql)) {
+        // another copy of the same statement was used concurrently and is already cached
+        sqlite3_finalize(stmt);
+        return;
+    }
+    cachedStatements.emplace_front(sql, stmt);
+    cachedStatementsBySql.emplace(cachedStatements.front().first, cachedStatements.begin());
+
+    if (cachedStatements.size() > STATEMENT_CACHE_SIZE) {
+        auto &last = cachedStatements.back();
+        sqlite3_finalize(last.second);
+        cachedStatementsBySql.erase(last.first);
+        cachedStatements.pop_back();
+    }
+}
+
+void
+SQLite3::clearStatementCache()
+{
+    for (auto &item : cachedStatements) {
+        sqlite3_finalize(item.second);
+    }
+    cachedStatements.clear();
+    cachedStatementsBySql.clear();
+}
@@ -28,10 +28,12 @@
 #include <sqlite3.h>
 
 #include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class SQLite3 {
@@ -55,6 +57,13 @@ public:
         const void *data;
     };
 
+    /**
+     * Tag for statements borrowed from the cache of prepared statements of the connection.
+     * The statement is returned to the cache, reset and with cleared bindings, when
+     * the borrowing Statement or Query is destroyed.
+     */
+    struct Cached {};
+
     class Statement {
     public:
         /**
@@ -91,6 +100,12 @@ public:
                 throw SQLite3::Error(db, result, "Creating statement failed");
         };
 
+        Statement(SQLite3 &db, const std::string &sql, Cached)
+          : db(db)
+          , stmt(db.acquireStatement(sql))
+          , cachedSql(sql)
+        {}
+
         void bind(int pos, int val)
         {
             auto result = sqlite3_bind_int(stmt, pos, val);
@@ -235,7 +250,10 @@ public:
         ~Statement()
         {
             freeExpandedSql();
-            sqlite3_finalize(stmt);
+            if (!cachedSql.empty())
+                db.releaseStatement(cachedSql, stmt);
+            else
+                sqlite3_finalize(stmt);
         };
 
     protected:
@@ -280,6 +298,8 @@ public:
         SQLite3 &db;
         sqlite3_stmt *stmt;
         char *expandSql{nullptr};
+        /// Key in the statement cache of db, empty for statements not borrowed from the cache
+        std::string cachedSql;
     };
 
     class Query : public Statement {
@@ -294,6 +314,11 @@ public:
         {
             mapColsName();
         }
+        Query(SQLite3 &db, const std::string &sql, Cached)
+          : Statement{db, sql, Cached{}}
+        {
+            mapColsName();
+        }
 
         int getColumnIndex(const std::string &colName)
         {
@@ -359,10 +384,21 @@ public:
     void backup(const std::string &outputFile);
     void restore(const std::string &inputFile);
 
+    /// Maximal number of idle prepared statements kept by the connection
+    static constexpr std::size_t STATEMENT_CACHE_SIZE = 64;
+
 protected:
+    sqlite3_stmt *acquireStatement(const std::string &sql);
+    void releaseStatement(const std::string &sql, sqlite3_stmt *stmt);
+    void clearStatementCache();
+
     std::string path;
 
     sqlite3 *db;
+
+    /// Idle prepared statements, the most recently used first
+    std::list< std::pair< std::string, sqlite3_stmt * > > cachedStatements;
+    std::unordered_map< std::string, decltype(cachedStatements)::iterator > cachedStatementsBySql;
 };
 
 typedef std::shared_ptr< SQLite3 > SQLite3Ptr;
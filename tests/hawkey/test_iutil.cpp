@@ -101,6 +101,51 @@ START_TEST(test_checksum)
 }
 END_TEST
 
+START_TEST(test_checksum_fp_mapped)
+{
+    char *new_file = solv_dupjoin(test_globals.tmpdir,
+                                  "/test_checksum_fp_mapped", NULL);
+    /* larger than a single read block of the non-mapped path */
+    const size_t len = 3 * 1024 * 1024 + 17;
+    char *content = static_cast<char *>(g_malloc(len));
+    for (size_t i = 0; i < len; ++i)
+        content[i] = 'a' + i % 23;
+    fail_unless(g_file_set_contents(new_file, content, len, NULL));
+
+    unsigned char cs_mapped[CHKSUM_BYTES];
+    unsigned char cs_cached[CHKSUM_BYTES];
+    unsigned char cs_stream[CHKSUM_BYTES];
+    unsigned char cs_changed[CHKSUM_BYTES];
+
+    /* regular file is memory mapped, a memory stream has no descriptor */
+    FILE *fp = fopen(new_file, "r");
+    fail_if(checksum_fp(cs_mapped, fp));
+    fail_unless(ftell(fp) == 0);
+    fclose(fp);
+    fp = fmemopen(content, len, "r");
+    fail_if(checksum_fp(cs_stream, fp));
+    fclose(fp);
+    fail_if(checksum_cmp(cs_mapped, cs_stream));
+
+    /* unchanged file gives the same checksum, memoized */
+    fp = fopen(new_file, "r");
+    fail_if(checksum_fp(cs_cached, fp));
+    fclose(fp);
+    fail_if(checksum_cmp(cs_mapped, cs_cached));
+
+    /* a write through the same stream is seen */
+    fp = fopen(new_file, "r+");
+    fail_if(fseek(fp, 0, SEEK_END));
+    fail_unless(fwrite("X", 1, 1, fp) == 1);
+    fail_if(checksum_fp(cs_changed, fp));
+    fclose(fp);
+    fail_unless(checksum_cmp(cs_mapped, cs_changed));
+
+    g_free(content);
+    g_free(new_file);
+}
+END_TEST
+
 START_TEST(test_dnf_solvfile_userdata)
 {
     char *new_file = solv_dupjoin(test_globals.tmpdir,
@@ -193,6 +238,7 @@ iutil_suite(void)
     TCase *tc = tcase_create("Main");
     tcase_add_test(tc, test_abspath);
     tcase_add_test(tc, test_checksum);
+    tcase_add_test(tc, test_checksum_fp_mapped);
     tcase_add_test(tc, test_dnf_solvfile_userdata);
     tcase_add_test(tc, test_mkcachedir);
     tcase_add_test(tc, test_version_split);
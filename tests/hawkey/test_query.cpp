@@ -385,6 +385,47 @@ START_TEST(test_query_recommends)
 }
 END_TEST
 
+START_TEST(test_query_requires_pkg)
+{
+    DnfSack *sack = test_globals.sack;
+
+    HyQuery q = hy_query_create(sack);
+    hy_query_filter(q, HY_PKG_NAME, HY_EQ, "penny-lib");
+    DnfPackageSet *pset = hy_query_run_set(q);
+    hy_query_free(q);
+    fail_unless(dnf_packageset_count(pset) == 3);
+
+    // penny-lib provides P-lib required by both the installed and the available flying
+    q = hy_query_create(sack);
+    fail_if(hy_query_filter_package_in(q, HY_PKG_REQUIRES, HY_EQ, pset));
+    GPtrArray *plist = hy_query_run(q);
+    fail_unless(plist->len == 2);
+    for (guint i = 0; i < plist->len; ++i) {
+        auto pkg = static_cast<DnfPackage *>(g_ptr_array_index(plist, i));
+        ck_assert_str_eq(dnf_package_get_name(pkg), "flying");
+    }
+    g_ptr_array_unref(plist);
+    hy_query_free(q);
+
+    q = hy_query_create(sack);
+    fail_if(hy_query_filter_package_in(q, HY_PKG_REQUIRES, HY_NEQ, pset));
+    fail_unless(query_count_results(q) == dnf_sack_count(sack) - 2);
+    hy_query_free(q);
+    delete pset;
+
+    // nothing requires penny
+    q = hy_query_create(sack);
+    hy_query_filter(q, HY_PKG_NAME, HY_EQ, "penny");
+    pset = hy_query_run_set(q);
+    hy_query_free(q);
+    q = hy_query_create(sack);
+    fail_if(hy_query_filter_package_in(q, HY_PKG_REQUIRES, HY_EQ, pset));
+    fail_unless(query_count_results(q) == 0);
+    hy_query_free(q);
+    delete pset;
+}
+END_TEST
+
 START_TEST(test_query_suggests)
 {
     GPtrArray *plist;
@@ -837,6 +878,79 @@ START_TEST(test_excluded)
 }
 END_TEST
 
+static int
+count_name(DnfSack *sack, const char *name,
+           libdnf::Query::ExcludeFlags flags = libdnf::Query::ExcludeFlags::APPLY_EXCLUDES)
+{
+    libdnf::Query q(sack, flags);
+    q.addFilter(HY_PKG_NAME, HY_EQ, name);
+    return q.size();
+}
+
+START_TEST(test_excluded_incremental)
+{
+    DnfSack *sack = test_globals.sack;
+    int jays = count_name(sack, "jay");
+    int pennies = count_name(sack, "penny");
+    fail_unless(jays > 0);
+    fail_unless(pennies > 0);
+
+    HyQuery q = hy_query_create_flags(sack, HY_IGNORE_EXCLUDES);
+    hy_query_filter(q, HY_PKG_NAME, HY_EQ, "jay");
+    DnfPackageSet *jay_set = hy_query_run_set(q);
+    hy_query_free(q);
+    q = hy_query_create_flags(sack, HY_IGNORE_EXCLUDES);
+    hy_query_filter(q, HY_PKG_NAME, HY_EQ, "penny");
+    DnfPackageSet *penny_set = hy_query_run_set(q);
+    hy_query_free(q);
+
+    // every change of excludes is visible to the next query
+    dnf_sack_add_excludes(sack, jay_set);
+    fail_unless(count_name(sack, "jay") == 0);
+    fail_unless(count_name(sack, "jay", libdnf::Query::ExcludeFlags::IGNORE_EXCLUDES) == jays);
+    dnf_sack_add_excludes(sack, penny_set);
+    fail_unless(count_name(sack, "penny") == 0);
+    dnf_sack_remove_excludes(sack, jay_set);
+    fail_unless(count_name(sack, "jay") == jays);
+    fail_unless(count_name(sack, "penny") == 0);
+
+    // a package excluded twice stays excluded until removed from both
+    dnf_sack_add_module_excludes(sack, penny_set);
+    dnf_sack_remove_excludes(sack, penny_set);
+    fail_unless(count_name(sack, "penny") == 0);
+    fail_unless(count_name(sack, "penny",
+                           libdnf::Query::ExcludeFlags::IGNORE_MODULAR_EXCLUDES) == pennies);
+    dnf_sack_remove_module_excludes(sack, penny_set);
+    fail_unless(count_name(sack, "penny") == pennies);
+
+    dnf_sack_set_excludes(sack, jay_set);
+    fail_unless(count_name(sack, "jay") == 0);
+    dnf_sack_set_excludes(sack, penny_set);
+    fail_unless(count_name(sack, "jay") == jays);
+    fail_unless(count_name(sack, "penny") == 0);
+    dnf_sack_reset_excludes(sack);
+    fail_unless(count_name(sack, "penny") == pennies);
+
+    // includes hide everything else in repos using them
+    dnf_sack_set_use_includes(sack, NULL, TRUE);
+    dnf_sack_set_includes(sack, jay_set);
+    fail_unless(count_name(sack, "jay") == jays);
+    fail_unless(count_name(sack, "penny") == 0);
+    dnf_sack_add_includes(sack, penny_set);
+    fail_unless(count_name(sack, "penny") == pennies);
+    dnf_sack_remove_includes(sack, jay_set);
+    fail_unless(count_name(sack, "jay") == 0);
+    dnf_sack_add_includes(sack, jay_set);
+    dnf_sack_set_use_includes(sack, NULL, FALSE);
+    fail_unless(count_name(sack, "penny") == pennies);
+    dnf_sack_reset_includes(sack);
+    fail_unless(count_name(sack, "jay") == jays);
+
+    delete jay_set;
+    delete penny_set;
+}
+END_TEST
+
 START_TEST(test_disabled_repo)
 {
     DnfSack *sack = test_globals.sack;
@@ -1085,6 +1199,7 @@ query_suite(void)
     tcase_add_test(tc, test_query_provides_glob);
     tcase_add_test(tc, test_query_rco_glob);
     tcase_add_test(tc, test_query_recommends);
+    tcase_add_test(tc, test_query_requires_pkg);
     tcase_add_test(tc, test_query_suggests);
     tcase_add_test(tc, test_query_supplements);
     tcase_add_test(tc, test_query_enhances);
@@ -1113,6 +1228,7 @@ query_suite(void)
     tcase_add_unchecked_fixture(tc, fixture_with_main, teardown);
     tcase_add_checked_fixture(tc, fixture_reset, NULL);
     tcase_add_test(tc, test_excluded);
+    tcase_add_test(tc, test_excluded_incremental);
     tcase_add_test(tc, test_disabled_repo);
     suite_add_tcase(s, tc);
 
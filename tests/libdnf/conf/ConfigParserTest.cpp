@@ -0,0 +1,116 @@
+#include "ConfigParserTest.hpp"
+
+#include "libdnf/conf/ConfigParser.hpp"
+
+#include <map>
+#include <sstream>
+#include <string>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ConfigParserTest);
+
+static const std::map<std::string, std::string> substitutions = {
+    {"releasever", "33"},
+    {"basearch", "x86_64"},
+    {"dollar", "$basearch"},
+};
+
+static std::string substitute(std::string text)
+{
+    libdnf::ConfigParser::substitute(text, substitutions);
+    return text;
+}
+
+void ConfigParserTest::setUp()
+{}
+
+void ConfigParserTest::tearDown()
+{}
+
+void ConfigParserTest::testSubstitute()
+{
+    CPPUNIT_ASSERT_EQUAL(std::string("no variables"), substitute("no variables"));
+    CPPUNIT_ASSERT_EQUAL(std::string("fedora/33/x86_64/os"), substitute("fedora/$releasever/$basearch/os"));
+    CPPUNIT_ASSERT_EQUAL(std::string("fedora/33/x86_64/os"), substitute("fedora/${releasever}/${basearch}/os"));
+
+    // adjacent references
+    CPPUNIT_ASSERT_EQUAL(std::string("33x86_64"), substitute("${releasever}${basearch}"));
+    CPPUNIT_ASSERT_EQUAL(std::string("33x86_64"), substitute("$releasever$basearch"));
+    CPPUNIT_ASSERT_EQUAL(std::string("33-x86_64"), substitute("$releasever-$basearch"));
+
+    // the variable name ends at the first character not allowed in it
+    CPPUNIT_ASSERT_EQUAL(std::string("$releasever_1"), substitute("$releasever_1"));
+    CPPUNIT_ASSERT_EQUAL(std::string("33_1"), substitute("${releasever}_1"));
+
+    // unknown variables are kept
+    CPPUNIT_ASSERT_EQUAL(std::string("$unknown/${unknown}/33"), substitute("$unknown/${unknown}/$releasever"));
+
+    // substituted values are not substituted again
+    CPPUNIT_ASSERT_EQUAL(std::string("$basearch/x86_64"), substitute("$dollar/$basearch"));
+}
+
+void ConfigParserTest::testSubstituteMalformed()
+{
+    // trailing $
+    CPPUNIT_ASSERT_EQUAL(std::string("33/$"), substitute("$releasever/$"));
+    CPPUNIT_ASSERT_EQUAL(std::string("$"), substitute("$"));
+    CPPUNIT_ASSERT_EQUAL(std::string("$$"), substitute("$$"));
+
+    // unterminated ${ stops the substitution
+    CPPUNIT_ASSERT_EQUAL(std::string("33/${basearch"), substitute("$releasever/${basearch"));
+    CPPUNIT_ASSERT_EQUAL(std::string("33/${"), substitute("$releasever/${"));
+
+    // invalid characters inside ${} make it a literal
+    CPPUNIT_ASSERT_EQUAL(std::string("${base-arch}/x86_64"), substitute("${base-arch}/$basearch"));
+
+    // empty names
+    CPPUNIT_ASSERT_EQUAL(std::string("${}/x86_64"), substitute("${}/$basearch"));
+    CPPUNIT_ASSERT_EQUAL(std::string("$/x86_64"), substitute("$/$basearch"));
+    std::string text = "${}/$-";
+    libdnf::ConfigParser::substitute(text, {{"", "empty"}});
+    CPPUNIT_ASSERT_EQUAL(std::string("empty/empty-"), text);
+}
+
+void ConfigParserTest::testSubstitutedValueCache()
+{
+    libdnf::ConfigParser parser;
+    parser.read(std::unique_ptr<std::istream>(new std::istringstream(
+        "[fedora]\n"
+        "baseurl=http://example.com/$releasever/${basearch}/$unknown\n"
+        "name=Fedora\n")));
+    parser.setSubstitutions(substitutions);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("http://example.com/33/x86_64/$unknown"),
+                         parser.getSubstitutedValue("fedora", "baseurl"));
+    // served from the cache
+    CPPUNIT_ASSERT_EQUAL(std::string("http://example.com/33/x86_64/$unknown"),
+                         parser.getSubstitutedValue("fedora", "baseurl"));
+    CPPUNIT_ASSERT_EQUAL(std::string("Fedora"), parser.getSubstitutedValue("fedora", "name"));
+
+    // new substitutions are used
+    parser.setSubstitutions({{"releasever", "34"}, {"basearch", "aarch64"}, {"unknown", "known"}});
+    CPPUNIT_ASSERT_EQUAL(std::string("http://example.com/34/aarch64/known"),
+                         parser.getSubstitutedValue("fedora", "baseurl"));
+
+    // a changed raw value is compiled again
+    parser.setValue("fedora", "baseurl", "http://example.com/$basearch");
+    CPPUNIT_ASSERT_EQUAL(std::string("http://example.com/aarch64"),
+                         parser.getSubstitutedValue("fedora", "baseurl"));
+    parser.setValue("fedora", "name", "Fedora $releasever");
+    CPPUNIT_ASSERT_EQUAL(std::string("Fedora 34"), parser.getSubstitutedValue("fedora", "name"));
+
+    // the raw values are not modified
+    CPPUNIT_ASSERT_EQUAL(std::string("http://example.com/$basearch"), parser.getValue("fedora", "baseurl"));
+
+    // a value modified through getData() is not served from the compiled one
+    parser.getData()["fedora"]["name"] = "Fedora $basearch";
+    CPPUNIT_ASSERT_EQUAL(std::string("Fedora aarch64"), parser.getSubstitutedValue("fedora", "name"));
+
+    // a removed and set again value is compiled again
+    CPPUNIT_ASSERT(parser.removeOption("fedora", "baseurl"));
+    parser.setValue("fedora", "baseurl", "http://example.com/$releasever");
+    CPPUNIT_ASSERT_EQUAL(std::string("http://example.com/34"), parser.getSubstitutedValue("fedora", "baseurl"));
+    CPPUNIT_ASSERT(parser.removeSection("fedora"));
+    CPPUNIT_ASSERT(parser.addSection("fedora"));
+    parser.setValue("fedora", "name", "Fedora");
+    CPPUNIT_ASSERT_EQUAL(std::string("Fedora"), parser.getSubstitutedValue("fedora", "name"));
+}
@@ -0,0 +1,24 @@
+#ifndef LIBDNF_CONFIGPARSERTEST_HPP
+#define LIBDNF_CONFIGPARSERTEST_HPP
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class ConfigParserTest : public CppUnit::TestCase
+{
+    CPPUNIT_TEST_SUITE(ConfigParserTest);
+        CPPUNIT_TEST(testSubstitute);
+        CPPUNIT_TEST(testSubstituteMalformed);
+        CPPUNIT_TEST(testSubstitutedValueCache);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+    void testSubstitute();
+    void testSubstituteMalformed();
+    void testSubstitutedValueCache();
+};
+
+#endif // LIBDNF_CONFIGPARSERTEST_HPP
@@ -223,6 +223,7 @@ dnf_repo_setup_with_empty_keyfile(void)
 static guint _allow_cancel_updates = 0;
 static guint _action_updates = 0;
 static guint _package_progress_updates = 0;
+static guint _last_package_percent = 0;
 static guint _last_percent = 0;
 static guint _updates = 0;
 
@@ -253,6 +254,7 @@ dnf_state_test_package_progress_changed_cb(DnfState *state,
                         gpointer data)
 {
     g_assert(data == NULL);
+    _last_package_percent = percentage;
     _package_progress_updates++;
 }
 
@@ -809,6 +811,67 @@ dnf_state_small_step_func(void)
     g_object_unref(state);
 }
 
+static void
+dnf_state_test_throttle_run(guint percentage_delta)
+{
+    DnfState *state;
+    DnfState *child;
+    gboolean ret;
+    GError *error = NULL;
+    guint i;
+
+    _updates = 0;
+    _last_percent = 0;
+    _package_progress_updates = 0;
+    _last_package_percent = 0;
+
+    state = dnf_state_new();
+    dnf_state_set_progress_throttle(state, percentage_delta, 0);
+    g_signal_connect(state, "percentage-changed",
+            G_CALLBACK(dnf_state_test_percentage_changed_cb), NULL);
+    g_signal_connect(state, "package-progress-changed",
+            G_CALLBACK(dnf_state_test_package_progress_changed_cb), NULL);
+    dnf_state_set_number_steps(state, 2);
+
+    /* the child inherits the throttle */
+    child = dnf_state_get_child(state);
+    dnf_state_set_number_steps(child, 100000);
+    for (i = 0; i < 100000; i++) {
+        ret = dnf_state_done(child, &error);
+        g_assert_no_error(error);
+        g_assert(ret);
+    }
+    for (i = 0; i <= 1000; i++)
+        dnf_state_set_package_progress(child,
+                                       "hal;0.0.1;i386;fedora",
+                                       DNF_STATE_ACTION_DOWNLOAD,
+                                       i / 10);
+    ret = dnf_state_done(state, &error);
+    g_assert_no_error(error);
+    g_assert(ret);
+
+    /* the final state is always delivered */
+    g_assert_cmpint(dnf_state_get_percentage(state), ==, 100);
+    g_assert_cmpint(_last_percent, ==, 100);
+    g_assert_cmpint(_last_package_percent, ==, 100);
+
+    g_object_unref(state);
+}
+
+static void
+dnf_state_throttle_func(void)
+{
+    /* every change of the child is proxied to the parent */
+    dnf_state_test_throttle_run(0);
+    g_assert_cmpint(_updates, ==, 51);
+    g_assert_cmpint(_package_progress_updates, ==, 1001);
+
+    /* only changes of at least 10% are emitted */
+    dnf_state_test_throttle_run(10);
+    g_assert_cmpint(_updates, ==, 6);
+    g_assert_cmpint(_package_progress_updates, ==, 11);
+}
+
 static void
 dnf_repo_loader_func(void)
 {
@@ -1252,6 +1315,7 @@ main(int argc, char **argv)
     g_test_add_func("/libdnf/state[locking]", dnf_state_locking_func);
     g_test_add_func("/libdnf/state[finished]", dnf_state_finished_func);
     g_test_add_func("/libdnf/state[small-step]", dnf_state_small_step_func);
+    g_test_add_func("/libdnf/state[throttle]", dnf_state_throttle_func);
 
     return g_test_run();
 }
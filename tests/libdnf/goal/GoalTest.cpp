@@ -0,0 +1,275 @@
+#include "GoalTest.hpp"
+
+#include "libdnf/dnf-sack-private.hpp"
+#include "libdnf/hy-iutil-private.hpp"
+#include "libdnf/hy-package-private.hpp"
+#include "libdnf/goal/Goal.hpp"
+#include "libdnf/repo/Repo-private.hpp"
+#include "libdnf/repo/solvable/DependencyContainer.hpp"
+#include "libdnf/sack/query.hpp"
+#include "libdnf/sack/selector.hpp"
+
+#include <solv/testcase.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GoalTest);
+
+#define UNITTEST_DIR "/tmp/libdnfXXXXXX"
+
+static const char * SYSTEM_REPO =
+    "=Ver: 2.0\n"
+    "=Pkg: app 1 1 x86_64\n"
+    "=Rec: lib-a\n"
+    "=Rec: lib-b >= 2\n"
+    "=Rec: (lib-c if lib-e)\n"
+    "=Rec: lib-d\n"
+    "=Rec: vprov\n"
+    "=Rec: missing\n"
+    "=Pkg: tool 1 1 noarch\n"
+    "=Rec: lib-a\n"
+    "=Rec: lib-d = 2\n"
+    "=Pkg: lib-d 1 1 x86_64\n";
+
+static const char * AVAILABLE_REPO =
+    "=Ver: 2.0\n"
+    "=Pkg: app 2 1 x86_64\n"
+    "=Rec: lib-a\n"
+    "=Rec: lib-b >= 2\n"
+    "=Rec: (lib-c if lib-e)\n"
+    "=Rec: lib-d\n"
+    "=Rec: vprov\n"
+    "=Rec: missing\n"
+    "=Pkg: lib-a 1 1 x86_64\n"
+    "=Pkg: lib-a 1 1 i686\n"
+    "=Pkg: lib-b 1 1 x86_64\n"
+    "=Pkg: lib-c 1 1 x86_64\n"
+    "=Pkg: lib-d 2 1 x86_64\n"
+    "=Pkg: lib-e 1 1 x86_64\n"
+    "=Pkg: provider 1 1 noarch\n"
+    "=Prv: vprov\n";
+
+void GoalTest::setUp()
+{
+    tmpdir = g_strdup(UNITTEST_DIR);
+    char *retptr = mkdtemp(tmpdir);
+    CPPUNIT_ASSERT(retptr);
+
+    sack = dnf_sack_new();
+    dnf_sack_set_cachedir(sack, tmpdir);
+    dnf_sack_set_arch(sack, "x86_64", NULL);
+    dnf_sack_setup(sack, 0, NULL);
+    loadRepo(HY_SYSTEM_REPO_NAME, SYSTEM_REPO, true);
+    loadRepo("available", AVAILABLE_REPO, false);
+}
+
+void GoalTest::tearDown()
+{
+    dnf_remove_recursive_v2(tmpdir, NULL);
+    g_object_unref(sack);
+    g_free(tmpdir);
+}
+
+void GoalTest::loadRepo(const char * name, const char * content, bool installed)
+{
+    Pool * pool = dnf_sack_get_pool(sack);
+    HyRepo hrepo = hy_repo_create(name);
+    Repo * repo = repo_create(pool, name);
+    libdnf::repoGetImpl(hrepo)->attachLibsolvRepo(repo);
+    hy_repo_free(hrepo);
+
+    FILE * fp = fmemopen(const_cast<char *>(content), strlen(content), "r");
+    CPPUNIT_ASSERT(fp);
+    testcase_add_testtags(repo, fp, 0);
+    fclose(fp);
+    if (installed)
+        pool_set_installed(pool, repo);
+}
+
+/// Reference implementation resolving every recommend of every installed package by its own query
+libdnf::PackageSet GoalTest::perRecommendExcludes()
+{
+    libdnf::PackageSet result(sack);
+    libdnf::Query installed_query(sack, libdnf::Query::ExcludeFlags::IGNORE_EXCLUDES);
+    installed_query.installed();
+    libdnf::Query base_query(sack);
+    base_query.apply();
+    auto * installed_pset = installed_query.getResultPset();
+    Id installed_id = -1;
+    while ((installed_id = installed_pset->next(installed_id)) != -1) {
+        g_autoptr(DnfPackage) pkg = dnf_package_new(sack, installed_id);
+        std::unique_ptr<libdnf::DependencyContainer> recommends(dnf_package_get_recommends(pkg));
+        for (int i = 0; i < recommends->count(); ++i) {
+            std::unique_ptr<libdnf::Dependency> dep(recommends->getPtr(i));
+            if (dep->toString()[0] == '(') {
+                continue;
+            }
+            libdnf::Query query(base_query);
+            const char * version = dep->getVersion();
+            if (version && strlen(version) > 0) {
+                query.addFilter(HY_PKG_PROVIDES, HY_EQ, dep->getName());
+            } else {
+                query.addFilter(HY_PKG_PROVIDES, dep.get());
+            }
+            if (query.empty()) {
+                continue;
+            }
+            libdnf::Query test_installed(query);
+            test_installed.installed();
+            if (test_installed.empty()) {
+                result += *query.getResultPset();
+            }
+        }
+    }
+    return result;
+}
+
+void GoalTest::testExcludeFromWeakAutodetect()
+{
+    auto expected = perRecommendExcludes();
+
+    // lib-a (both arches), lib-b (version ignored) and provider of vprov; lib-c is behind a rich
+    // dependency and lib-d has an installed provider
+    std::vector<std::string> nevras;
+    Id id = -1;
+    while ((id = expected.next(id)) != -1) {
+        g_autoptr(DnfPackage) pkg = dnf_package_new(sack, id);
+        nevras.push_back(dnf_package_get_nevra(pkg));
+    }
+    std::sort(nevras.begin(), nevras.end());
+    std::vector<std::string> reference{
+        "lib-a-1-1.i686", "lib-a-1-1.x86_64", "lib-b-1-1.x86_64", "provider-1-1.noarch"};
+    CPPUNIT_ASSERT(nevras == reference);
+
+    // Excluded packages are not considered by either of algorithms
+    libdnf::Query lib_a(sack);
+    lib_a.addFilter(HY_PKG_NAME, HY_EQ, "lib-a");
+    lib_a.addFilter(HY_PKG_ARCH, HY_EQ, "i686");
+    dnf_sack_add_excludes(sack, lib_a.getResultPset());
+    auto expected_considered = perRecommendExcludes();
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), expected_considered.size());
+
+    libdnf::Goal autodetect(sack);
+    autodetect.exclude_from_weak_autodetect();
+    autodetect.upgrade();
+    CPPUNIT_ASSERT(!autodetect.run(DNF_NONE));
+
+    libdnf::Goal manual(sack);
+    manual.add_exclude_from_weak(expected_considered);
+    manual.upgrade();
+    CPPUNIT_ASSERT(!manual.run(DNF_NONE));
+
+    auto installs = autodetect.listInstalls();
+    CPPUNIT_ASSERT_EQUAL(manual.listInstalls().size(), installs.size());
+    Id pkg_id = -1;
+    while ((pkg_id = installs.next(pkg_id)) != -1) {
+        CPPUNIT_ASSERT(!expected_considered.has(pkg_id));
+    }
+
+    // Without the exclusion the upgraded app pulls its recommends in
+    libdnf::Goal plain(sack);
+    plain.upgrade();
+    CPPUNIT_ASSERT(!plain.run(DNF_NONE));
+    CPPUNIT_ASSERT(plain.listInstalls().size() > installs.size());
+}
+
+void GoalTest::testWideGlobSelector()
+{
+    // Every name is provided by two architectures so the glob iterator finds each name twice
+    constexpr int NAMES = 30000;
+    std::string content = "=Ver: 2.0\n";
+    for (int i = 0; i < NAMES; ++i) {
+        auto name = "lib" + std::to_string(i);
+        content += "=Pkg: " + name + " 1 1 x86_64\n=Prv: libprov\n";
+        content += "=Pkg: " + name + " 1 1 i686\n=Prv: libprov\n";
+    }
+    loadRepo("wide", content.c_str(), false);
+
+    auto start = std::chrono::steady_clock::now();
+
+    libdnf::Selector names(sack);
+    CPPUNIT_ASSERT_EQUAL(0, names.set(HY_PKG_NAME, HY_GLOB, "lib*"));
+    libdnf::Goal name_goal(sack);
+    name_goal.install(&names, true);
+    // lib-a .. lib-e from the fixture match the glob as well
+    CPPUNIT_ASSERT_EQUAL(NAMES + 5, name_goal.jobLength());
+
+    libdnf::Selector provides(sack);
+    CPPUNIT_ASSERT_EQUAL(0, provides.set(HY_PKG_PROVIDES, HY_GLOB, "libpro*"));
+    libdnf::Goal provides_goal(sack);
+    provides_goal.install(&provides, true);
+    CPPUNIT_ASSERT_EQUAL(1, provides_goal.jobLength());
+
+    // Each matched name used to rescan the whole job; the bound is loose to stay stable on slow builders
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    CPPUNIT_ASSERT(elapsed < std::chrono::seconds(10));
+}
+
+void GoalTest::testClassifyResults()
+{
+    libdnf::Goal goal(sack);
+    CPPUNIT_ASSERT_THROW(goal.classifyResults(), libdnf::Goal::Error);
+
+    goal.upgrade();
+    CPPUNIT_ASSERT(!goal.run(DNF_IGNORE_WEAK_DEPS));
+    auto & results = goal.classifyResults();
+    // app and lib-d are upgraded, nothing else changes without weak dependencies
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), results.upgrades.size());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), results.installs.size());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), results.erasures.size());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), results.downgrades.size());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), results.reinstalls.size());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), results.obsoleted.size());
+    CPPUNIT_ASSERT(&results == &goal.classifyResults());
+    CPPUNIT_ASSERT_EQUAL(results.upgrades.size(), goal.listUpgrades().size());
+    CPPUNIT_ASSERT_EQUAL(results.obsoleted.size(), goal.listObsoleted().size());
+
+    // Solving again drops the cached classification
+    CPPUNIT_ASSERT(!goal.run(DNF_NONE));
+    auto & weak_results = goal.classifyResults();
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), weak_results.upgrades.size());
+    CPPUNIT_ASSERT(weak_results.installs.size() > 0);
+    CPPUNIT_ASSERT_EQUAL(weak_results.installs.size(), goal.listInstalls().size());
+}
+
+void GoalTest::testDescribeAllProblemRules()
+{
+    loadRepo("broken",
+        "=Ver: 2.0\n"
+        "=Pkg: broken-a 1 1 noarch\n"
+        "=Req: nowhere\n"
+        "=Pkg: broken-b 1 1 noarch\n"
+        "=Req: nowhere\n", false);
+
+    libdnf::Goal goal(sack);
+    for (auto name : {"broken-a", "broken-b"}) {
+        libdnf::Selector selector(sack);
+        selector.set(HY_PKG_NAME, HY_EQ, name);
+        goal.install(&selector, false);
+    }
+    CPPUNIT_ASSERT(goal.run(DNF_NONE));
+    CPPUNIT_ASSERT_EQUAL(2, goal.countProblems());
+
+    auto problems = goal.describeAllProblemRules(true);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), problems.size());
+    for (unsigned i = 0; i < problems.size(); ++i) {
+        CPPUNIT_ASSERT(problems[i] == goal.describeProblemRules(i, true));
+        std::vector<std::string> sorted(problems[i]);
+        std::sort(sorted.begin(), sorted.end());
+        CPPUNIT_ASSERT(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+    }
+    CPPUNIT_ASSERT(problems[0] != problems[1]);
+
+    // The same problems reported twice in one goal are described once
+    libdnf::Goal twice(sack);
+    for (int i = 0; i < 2; ++i) {
+        libdnf::Selector selector(sack);
+        selector.set(HY_PKG_NAME, HY_EQ, "broken-a");
+        twice.install(&selector, false);
+    }
+    CPPUNIT_ASSERT(twice.run(DNF_NONE));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), twice.describeAllProblemRules(true).size());
+}
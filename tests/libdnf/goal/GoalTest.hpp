@@ -0,0 +1,36 @@
+#ifndef LIBDNF_GOALTEST_HPP
+#define LIBDNF_GOALTEST_HPP
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <libdnf/dnf-sack.h>
+#include <libdnf/sack/packageset.hpp>
+
+class GoalTest : public CppUnit::TestCase
+{
+    CPPUNIT_TEST_SUITE(GoalTest);
+        CPPUNIT_TEST(testExcludeFromWeakAutodetect);
+        CPPUNIT_TEST(testWideGlobSelector);
+        CPPUNIT_TEST(testClassifyResults);
+        CPPUNIT_TEST(testDescribeAllProblemRules);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+    void testExcludeFromWeakAutodetect();
+    void testWideGlobSelector();
+    void testClassifyResults();
+    void testDescribeAllProblemRules();
+
+private:
+    void loadRepo(const char * name, const char * content, bool installed);
+    libdnf::PackageSet perRecommendExcludes();
+
+    DnfSack *sack = nullptr;
+    char* tmpdir = nullptr;
+};
+
+#endif //LIBDNF_GOALTEST_HPP
@@ -5,8 +5,13 @@ CPPUNIT_TEST_SUITE_REGISTRATION(ModulePackageContainerTest);
 #include "libdnf/log.hpp"
 #include "libdnf/dnf-sack-private.hpp"
 #include "libdnf/hy-iutil-private.hpp"
+#include "libdnf/repo/Repo-private.hpp"
+#include "libdnf/sack/query.hpp"
+
+#include <solv/testcase.h>
 
 #include <algorithm>
+#include <cstring>
 
 #define UNITTEST_DIR "/tmp/libdnf22XXXXXX"
 
@@ -156,3 +161,314 @@ void ModulePackageContainerTest::testInstallRemoveProfile()
 
     modules->save();
 }
+
+void ModulePackageContainerTest::testParallelSolving()
+{
+    auto activeModules = [this]() {
+        std::vector<Id> active;
+        for (auto modulePackage : modules->getModulePackages()) {
+            if (modules->isModuleActive(modulePackage)) {
+                active.push_back(modulePackage->getId());
+            }
+        }
+        std::sort(active.begin(), active.end());
+        return active;
+    };
+    auto compareSolving = [&]() {
+        modules->setParallelSolving(false);
+        auto sequential = modules->resolveActiveModulePackages(false);
+        auto sequentialActive = activeModules();
+        modules->setParallelSolving(true);
+        auto parallel = modules->resolveActiveModulePackages(false);
+        CPPUNIT_ASSERT(sequential.first == parallel.first);
+        CPPUNIT_ASSERT(sequential.second == parallel.second);
+        CPPUNIT_ASSERT(sequentialActive == activeModules());
+        return sequentialActive;
+    };
+
+    // Starting environment has httpd:2.4 and base-runtime:f26 enabled
+    CPPUNIT_ASSERT(!compareSolving().empty());
+
+    modules->disable("httpd");
+    compareSolving();
+
+    modules->reset("httpd");
+    modules->enable("httpd", "2.2");
+    compareSolving();
+
+    auto moduleYaml = [](const std::string & name, const std::string & stream, int version,
+                         const std::string & runtimeRequires) {
+        std::string yaml = "---\ndocument: modulemd\nversion: 2\ndata:\n"
+                           "  name: " + name + "\n"
+                           "  stream: " + stream + "\n"
+                           "  version: " + std::to_string(version) + "\n"
+                           "  context: c1\n"
+                           "  arch: x86_64\n"
+                           "  summary: Solving module\n"
+                           "  description: Solving module\n"
+                           "  license:\n"
+                           "    module: [MIT]\n";
+        if (!runtimeRequires.empty()) {
+            yaml += "  dependencies:\n  - requires:\n      " + runtimeRequires + "\n";
+        }
+        return yaml + "...\n";
+    };
+    modules->add(moduleYaml("broken", "latest", 1, "") +
+                 moduleYaml("broken", "latest", 2, "unavailable: [s1]") +
+                 moduleYaml("left", "a", 1, "shared: [one]") +
+                 moduleYaml("right", "a", 1, "shared: [two]") +
+                 moduleYaml("shared", "one", 1, "") +
+                 moduleYaml("shared", "two", 1, ""), "solving");
+
+    // The latest version cannot be installed, the strict goals fail and a relaxed one succeeds
+    modules->enable("broken", "latest");
+    auto problemType = modules->resolveActiveModulePackages(false).second;
+    CPPUNIT_ASSERT(problemType == libdnf::ModulePackageContainer::ModuleErrorType::ERROR_IN_DEFAULTS ||
+                   problemType == libdnf::ModulePackageContainer::ModuleErrorType::ERROR_IN_LATEST);
+    compareSolving();
+    modules->reset("broken");
+
+    // Enabled modules require conflicting streams, no goal succeeds and conflicting modules are
+    // dropped
+    modules->enable("left", "a");
+    modules->enable("right", "a");
+    problemType = modules->resolveActiveModulePackages(false).second;
+    CPPUNIT_ASSERT(problemType == libdnf::ModulePackageContainer::ModuleErrorType::ERROR);
+    CPPUNIT_ASSERT(!compareSolving().empty());
+}
+
+void ModulePackageContainerTest::testQueryIndex()
+{
+    // thousands of contexts of a few streams
+    constexpr int streams = 4;
+    constexpr int contexts = 600;
+    std::string yaml;
+    for (int stream = 0; stream < streams; ++stream) {
+        for (int context = 0; context < contexts; ++context) {
+            yaml += "---\ndocument: modulemd\nversion: 2\ndata:\n"
+                    "  name: bulk\n"
+                    "  stream: s" + std::to_string(stream) + "\n"
+                    "  version: " + std::to_string(1 + context % 3) + "\n"
+                    "  context: c" + std::to_string(context) + "\n";
+            if (context % 5) {
+                yaml += "  arch: x86_64\n";
+            }
+            yaml += "  summary: Bulk module\n"
+                    "  description: Bulk module\n"
+                    "  license:\n"
+                    "    module: [MIT]\n"
+                    "...\n";
+        }
+    }
+    modules->add(yaml, "bulk");
+
+    auto ids = [](const std::vector<libdnf::ModulePackage *> & packages) {
+        std::vector<Id> result;
+        for (auto modulePackage : packages) {
+            result.push_back(modulePackage->getId());
+        }
+        return result;
+    };
+
+    // "bul[k]" is a glob, so it is resolved by a Query over the module sack instead of the index
+    struct Lookup { std::string stream, version, context, arch; size_t expected; };
+    const std::vector<Lookup> lookups = {
+        {"s1", "", "", "", contexts},
+        {"s2", "", "c42", "", 1},
+        {"s2", "2", "", "", contexts / 3},
+        {"s3", "", "", "noarch", contexts / 5},
+        {"s3", "", "", "x86_64", contexts - contexts / 5},
+        {"s0", "", "c1*", "", 111},
+        {"s0", "[13]", "c4?", "x86_*", 5},
+        {"s0", "", "c1000", "", 0},
+        {"s9", "", "", "", 0},
+    };
+    for (const auto & lookup : lookups) {
+        auto indexed = ids(modules->query("bulk", lookup.stream, lookup.version, lookup.context, lookup.arch));
+        auto queried = ids(modules->query("bul[k]", lookup.stream, lookup.version, lookup.context, lookup.arch));
+        CPPUNIT_ASSERT(indexed == queried);
+        CPPUNIT_ASSERT_EQUAL(lookup.expected, indexed.size());
+    }
+
+    // the index is refreshed when modules are added
+    modules->add(
+        "---\ndocument: modulemd\nversion: 2\ndata:\n"
+        "  name: bulk\n  stream: s9\n  version: 1\n  context: late\n  arch: x86_64\n"
+        "  summary: Bulk module\n  description: Bulk module\n  license:\n    module: [MIT]\n...\n",
+        "bulk-late");
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), modules->query("bulk", "s9", "", "", "").size());
+}
+
+void ModulePackageContainerTest::testRequiresModuleEnablement()
+{
+    // hundreds of active modules with tens of artifacts each, even ones are active by default,
+    // odd ones are enabled and therefore never require enablement
+    constexpr int moduleCount = 300;
+    constexpr int artifactCount = 20;
+    std::string yaml;
+    std::string defaults;
+    std::vector<std::string> enabled;
+    std::string testtags = "=Ver: 2.0\n";
+    for (int module = 0; module < moduleCount; ++module) {
+        auto name = "bulk" + std::to_string(module);
+        yaml += "---\ndocument: modulemd\nversion: 2\ndata:\n"
+                "  name: " + name + "\n  stream: s\n  version: 1\n  context: c\n  arch: x86_64\n"
+                "  summary: Bulk module\n  description: Bulk module\n  license:\n    module: [MIT]\n"
+                "  artifacts:\n    rpms:\n";
+        for (int artifact = 0; artifact < artifactCount; ++artifact) {
+            auto pkgName = name + "-pkg" + std::to_string(artifact);
+            yaml += "    - " + pkgName + "-0:1.0-1.x86_64\n";
+            testtags += "=Pkg: " + pkgName + " 1.0 1 x86_64\n";
+            testtags += "=Pkg: " + pkgName + " 2.0 1 x86_64\n";
+        }
+        yaml += "...\n";
+        if (module % 2) {
+            enabled.push_back(name);
+        } else {
+            defaults += "---\ndocument: modulemd-defaults\nversion: 1\ndata:\n"
+                        "  module: " + name + "\n  stream: s\n...\n";
+        }
+    }
+    modules->add(yaml, "bulk");
+    for (auto & name : enabled) {
+        modules->enable(name, "s");
+    }
+    g_autofree gchar * defaultsPath = g_build_filename(
+        tmpdir, "/etc/dnf/modules.defaults.d/bulk.yaml", NULL);
+    CPPUNIT_ASSERT(g_file_set_contents(defaultsPath, defaults.c_str(), -1, NULL));
+    modules->addDefaultsFromDisk();
+    modules->moduleDefaultsResolve();
+    modules->resolveActiveModulePackages(false);
+
+    DnfSack * sack = dnf_sack_new();
+    dnf_sack_set_arch(sack, "x86_64", NULL);
+    Pool * pool = dnf_sack_get_pool(sack);
+    HyRepo hrepo = hy_repo_create("bulk");
+    Repo * repo = repo_create(pool, "bulk");
+    libdnf::repoGetImpl(hrepo)->attachLibsolvRepo(repo);
+    hy_repo_free(hrepo);
+    FILE * fp = fmemopen(const_cast<char *>(testtags.c_str()), testtags.size(), "r");
+    CPPUNIT_ASSERT(fp);
+    testcase_add_testtags(repo, fp, 0);
+    fclose(fp);
+
+    auto ids = [](const std::vector<libdnf::ModulePackage *> & packages) {
+        std::vector<Id> result;
+        for (auto modulePackage : packages) {
+            result.push_back(modulePackage->getId());
+        }
+        return result;
+    };
+    // one NEVRA strict query per active module not enabled
+    auto reference = [&](const libdnf::PackageSet & packages) {
+        std::vector<Id> result;
+        for (auto modulePackage : modules->getModulePackages()) {
+            if (!modules->isModuleActive(modulePackage) || modules->isEnabled(modulePackage)) {
+                continue;
+            }
+            auto artifacts = modulePackage->getArtifacts();
+            std::vector<const char *> nevras;
+            for (auto & artifact : artifacts) {
+                nevras.push_back(artifact.c_str());
+            }
+            nevras.push_back(nullptr);
+            libdnf::Query query(packages.getSack());
+            query.addFilter(HY_PKG, HY_EQ, &packages);
+            query.addFilter(HY_PKG_NEVRA_STRICT, HY_EQ, nevras.data());
+            if (!query.empty()) {
+                result.push_back(modulePackage->getId());
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+    auto installSet = [&](const char * version) {
+        libdnf::Query query(sack);
+        query.addFilter(HY_PKG_VERSION, HY_EQ, version);
+        return *query.runSet();
+    };
+
+    // the whole repo at artifact versions
+    auto artifacts = installSet("1.0");
+    auto required = ids(modules->requiresModuleEnablement(artifacts));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(moduleCount / 2), required.size());
+    CPPUNIT_ASSERT(required == reference(artifacts));
+
+    // no package is an artifact
+    CPPUNIT_ASSERT(modules->requiresModuleEnablement(installSet("2.0")).empty());
+
+    // a single artifact
+    libdnf::Query single(sack);
+    single.addFilter(HY_PKG_NEVRA_STRICT, HY_EQ, "bulk42-pkg7-1.0-1.x86_64");
+    required = ids(modules->requiresModuleEnablement(*single.runSet()));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), required.size());
+    CPPUNIT_ASSERT_EQUAL(std::string("bulk42"), modules->getModulePackage(required[0])->getName());
+
+    // answers follow the active modules
+    modules->enable("bulk42", "s");
+    CPPUNIT_ASSERT(modules->requiresModuleEnablement(*single.runSet()).empty());
+    modules->reset("bulk42");
+    modules->disable("bulk42");
+    modules->resolveActiveModulePackages(false);
+    CPPUNIT_ASSERT(modules->requiresModuleEnablement(*single.runSet()).empty());
+    required = ids(modules->requiresModuleEnablement(artifacts));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(moduleCount / 2 - 1), required.size());
+    CPPUNIT_ASSERT(required == reference(artifacts));
+
+    g_object_unref(sack);
+}
+
+void ModulePackageContainerTest::testEnableDependencyTree()
+{
+    // a deep chain of modules, each of them also requires a shared leaf module
+    constexpr int depth = 500;
+    auto chainName = [](int link) { return "chain" + std::to_string(link); };
+    std::string yaml;
+    for (int link = 0; link < depth; ++link) {
+        yaml += "---\ndocument: modulemd\nversion: 2\ndata:\n"
+                "  name: " + chainName(link) + "\n  stream: s\n  version: 1\n  context: c\n  arch: x86_64\n"
+                "  summary: Chain module\n  description: Chain module\n  license:\n    module: [MIT]\n"
+                "  dependencies:\n  - requires:\n      leaf: [s]\n";
+        if (link + 1 < depth) {
+            yaml += "      " + chainName(link + 1) + ": [s]\n";
+        }
+        yaml += "...\n";
+    }
+    yaml += "---\ndocument: modulemd\nversion: 2\ndata:\n"
+            "  name: leaf\n  stream: s\n  version: 1\n  context: c\n  arch: x86_64\n"
+            "  summary: Leaf module\n  description: Leaf module\n  license:\n    module: [MIT]\n...\n";
+    modules->add(yaml, "chain");
+
+    // the whole chain is active, yet only its head is enabled
+    modules->enable(chainName(0), "s");
+    modules->resolveActiveModulePackages(false);
+    modules->reset(chainName(0));
+    for (int link = 0; link < depth; ++link) {
+        auto modulePackages = modules->query(chainName(link), "s", "", "", "");
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), modulePackages.size());
+        CPPUNIT_ASSERT(modules->isModuleActive(modulePackages[0]));
+        CPPUNIT_ASSERT(!modules->isEnabled(modulePackages[0]));
+    }
+
+    // from the middle of the chain, modules before it are left alone
+    auto middle = modules->query(chainName(depth / 2), "s", "", "", "");
+    modules->enableDependencyTree(middle);
+    for (int link = 0; link < depth; ++link) {
+        CPPUNIT_ASSERT_EQUAL(link >= depth / 2, modules->isEnabled(chainName(link), "s"));
+    }
+    CPPUNIT_ASSERT(modules->isEnabled("leaf", "s"));
+
+    auto head = modules->query(chainName(0), "s", "", "", "");
+    modules->enableDependencyTree(head);
+    for (int link = 0; link < depth; ++link) {
+        CPPUNIT_ASSERT(modules->isEnabled(chainName(link), "s"));
+    }
+
+    // inactive modules are not enabled and their requires are not followed
+    modules->reset("leaf");
+    modules->disable("leaf");
+    modules->resolveActiveModulePackages(false);
+    auto leaf = modules->query("leaf", "s", "", "", "");
+    modules->enableDependencyTree(leaf);
+    CPPUNIT_ASSERT(!modules->isEnabled("leaf", "s"));
+}
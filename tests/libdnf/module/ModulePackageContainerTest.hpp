@@ -14,6 +14,10 @@ class ModulePackageContainerTest : public CppUnit::TestCase
         CPPUNIT_TEST(testDisableEnableModules);
         CPPUNIT_TEST(testRollback);
         CPPUNIT_TEST(testInstallRemoveProfile);
+        CPPUNIT_TEST(testParallelSolving);
+        CPPUNIT_TEST(testQueryIndex);
+        CPPUNIT_TEST(testRequiresModuleEnablement);
+        CPPUNIT_TEST(testEnableDependencyTree);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -24,6 +28,10 @@ public:
     void testDisableEnableModules();
     void testRollback();
     void testInstallRemoveProfile();
+    void testParallelSolving();
+    void testQueryIndex();
+    void testRequiresModuleEnablement();
+    void testEnableDependencyTree();
 
 private:
     DnfContext *context;
@@ -0,0 +1,86 @@
+#include "ModuleMetadataTest.hpp"
+
+#include "libdnf/hy-iutil-private.hpp"
+#include "libdnf/module/modulemd/ModuleMetadata.hpp"
+#include "libdnf/utils/File.hpp"
+
+extern "C" {
+#   include <solv/solv_xfopen.h>
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ModuleMetadataTest);
+
+#define UNITTEST_DIR "/tmp/libdnfXXXXXX"
+
+static const char * DEFAULTS_DOCUMENT =
+    "---\n"
+    "document: modulemd-defaults\n"
+    "version: 1\n"
+    "data:\n"
+    "  module: httpd\n"
+    "  stream: 2.4\n"
+    "  profiles:\n"
+    "    2.4: [default]\n"
+    "...\n";
+
+void ModuleMetadataTest::setUp()
+{
+    tmpdir = g_strdup(UNITTEST_DIR);
+    char *retptr = mkdtemp(tmpdir);
+    CPPUNIT_ASSERT(retptr);
+
+    // spans several read chunks once decompressed
+    for (int i = 0; yaml.size() < 3 * libdnf::File::DEFAULT_CHUNK_SIZE; ++i) {
+        yaml += "# padding line " + std::to_string(i) + "\n";
+    }
+    yaml += DEFAULTS_DOCUMENT;
+
+    compressedPath = std::string(tmpdir) + "/modules.yaml.gz";
+    FILE * fp = solv_xfopen(compressedPath.c_str(), "w");
+    CPPUNIT_ASSERT(fp);
+    CPPUNIT_ASSERT_EQUAL(yaml.size(), fwrite(yaml.data(), 1, yaml.size(), fp));
+    CPPUNIT_ASSERT_EQUAL(0, fclose(fp));
+}
+
+void ModuleMetadataTest::tearDown()
+{
+    dnf_remove_recursive_v2(tmpdir, NULL);
+    g_free(tmpdir);
+}
+
+void ModuleMetadataTest::testCompressedContent()
+{
+    auto file = libdnf::File::newFile(compressedPath);
+    file->open("r");
+    CPPUNIT_ASSERT(file->getContent() == yaml);
+    file->close();
+
+    std::string streamed;
+    size_t chunks = 0;
+    file->open("r");
+    file->readChunks([&streamed, &chunks](const char * data, size_t length) {
+        streamed.append(data, length);
+        ++chunks;
+    }, 4096);
+    file->close();
+    CPPUNIT_ASSERT(streamed == yaml);
+    CPPUNIT_ASSERT_EQUAL((yaml.size() + 4095) / 4096, chunks);
+}
+
+void ModuleMetadataTest::testAddMetadataFromFile()
+{
+    libdnf::ModuleMetadata fromFile;
+    fromFile.addMetadataFromFile(compressedPath, 0);
+    fromFile.resolveAddedMetadata();
+
+    libdnf::ModuleMetadata fromString;
+    fromString.addMetadataFromString(yaml, 0);
+    fromString.resolveAddedMetadata();
+
+    auto defaults = fromFile.getDefaultStreams();
+    CPPUNIT_ASSERT_EQUAL(std::string("2.4"), defaults["httpd"]);
+    CPPUNIT_ASSERT(defaults == fromString.getDefaultStreams());
+
+    CPPUNIT_ASSERT_THROW(fromFile.addMetadataFromFile(std::string(tmpdir) + "/missing.yaml", 0),
+                         libdnf::File::OpenError);
+}
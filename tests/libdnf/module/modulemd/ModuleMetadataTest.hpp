@@ -0,0 +1,29 @@
+#ifndef LIBDNF_MODULEMETADATATEST_HPP
+#define LIBDNF_MODULEMETADATATEST_HPP
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+
+class ModuleMetadataTest : public CppUnit::TestCase
+{
+    CPPUNIT_TEST_SUITE(ModuleMetadataTest);
+        CPPUNIT_TEST(testCompressedContent);
+        CPPUNIT_TEST(testAddMetadataFromFile);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+    void testCompressedContent();
+    void testAddMetadataFromFile();
+
+private:
+    char * tmpdir;
+    std::string yaml;
+    std::string compressedPath;
+};
+
+#endif // LIBDNF_MODULEMETADATATEST_HPP
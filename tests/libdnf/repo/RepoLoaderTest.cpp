@@ -0,0 +1,155 @@
+#include "RepoLoaderTest.hpp"
+
+#include "libdnf/dnf-repo-loader-private.hpp"
+#include "libdnf/hy-iutil-private.hpp"
+
+#include <glib/gstdio.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RepoLoaderTest);
+
+#define UNITTEST_DIR "/tmp/libdnfXXXXXX"
+
+void RepoLoaderTest::setUp()
+{
+    tmpdir = g_strdup(UNITTEST_DIR);
+    char *retptr = mkdtemp(tmpdir);
+    CPPUNIT_ASSERT(retptr);
+    reposDir = std::string(tmpdir) + "/yum.repos.d";
+    CPPUNIT_ASSERT(g_mkdir_with_parents(reposDir.c_str(), 0755) == 0);
+    writeRepoFile("alpha", "Alpha");
+    writeRepoFile("beta", "Beta");
+
+    dnf_context_set_config_file_path("");
+    context = dnf_context_new();
+    dnf_context_set_release_ver(context, "26");
+    dnf_context_set_arch(context, "x86_64");
+    dnf_context_set_repo_dir(context, reposDir.c_str());
+    auto cache_dir = std::string(tmpdir) + "/cache";
+    dnf_context_set_cache_dir(context, cache_dir.c_str());
+    dnf_context_set_solv_dir(context, cache_dir.c_str());
+    dnf_context_set_lock_dir(context, tmpdir);
+    g_autoptr(GError) error = nullptr;
+    CPPUNIT_ASSERT(dnf_context_setup(context, nullptr, &error));
+}
+
+void RepoLoaderTest::tearDown()
+{
+    g_object_unref(context);
+    dnf_remove_recursive_v2(tmpdir, NULL);
+    g_free(tmpdir);
+}
+
+void RepoLoaderTest::writeRepoFile(const char * id, const char * name)
+{
+    auto path = reposDir + "/" + id + ".repo";
+    g_autofree gchar * content = g_strdup_printf(
+        "[%s]\nname=%s $releasever\nbaseurl=https://example.com/%s/$basearch/\nenabled=1\n",
+        id, name, id);
+    CPPUNIT_ASSERT(g_file_set_contents(path.c_str(), content, -1, NULL));
+}
+
+DnfRepo * RepoLoaderTest::getRepo(const char * id)
+{
+    g_autoptr(GError) error = nullptr;
+    auto repo = dnf_repo_loader_get_repo_by_id(dnf_context_get_repo_loader(context), id, &error);
+    CPPUNIT_ASSERT(repo != nullptr);
+    return DNF_REPO(g_object_ref(repo));
+}
+
+void RepoLoaderTest::testUnchangedFilesNotReparsed()
+{
+    auto loader = dnf_context_get_repo_loader(context);
+    g_autoptr(DnfRepo) alpha = getRepo("alpha");
+    g_autoptr(DnfRepo) beta = getRepo("beta");
+
+    // nothing changed, both repos are reused
+    dnf_repo_loader_invalidate(loader);
+    g_autoptr(DnfRepo) alpha_same = getRepo("alpha");
+    g_autoptr(DnfRepo) beta_same = getRepo("beta");
+    CPPUNIT_ASSERT(alpha == alpha_same);
+    CPPUNIT_ASSERT(beta == beta_same);
+
+    // touching a file reparses just that file
+    auto beta_path = reposDir + "/beta.repo";
+    struct stat st;
+    CPPUNIT_ASSERT(stat(beta_path.c_str(), &st) == 0);
+    struct utimbuf times{st.st_atime, st.st_mtime + 10};
+    CPPUNIT_ASSERT(utime(beta_path.c_str(), &times) == 0);
+    dnf_repo_loader_invalidate(loader);
+    g_autoptr(DnfRepo) alpha_touched = getRepo("alpha");
+    g_autoptr(DnfRepo) beta_touched = getRepo("beta");
+    CPPUNIT_ASSERT(alpha == alpha_touched);
+    CPPUNIT_ASSERT(beta != beta_touched);
+
+    // modified content is picked up
+    writeRepoFile("alpha", "Renamed");
+    dnf_repo_loader_invalidate(loader);
+    g_autoptr(DnfRepo) alpha_modified = getRepo("alpha");
+    g_autoptr(DnfRepo) beta_unmodified = getRepo("beta");
+    CPPUNIT_ASSERT(alpha != alpha_modified);
+    CPPUNIT_ASSERT(beta_touched == beta_unmodified);
+    CPPUNIT_ASSERT_EQUAL(std::string("Renamed 26"), std::string(dnf_repo_get_description(alpha_modified)));
+
+    // removed files drop their repos
+    CPPUNIT_ASSERT(g_unlink(beta_path.c_str()) == 0);
+    dnf_repo_loader_invalidate(loader);
+    g_autoptr(GError) error = nullptr;
+    CPPUNIT_ASSERT(dnf_repo_loader_get_repo_by_id(loader, "beta", &error) == nullptr);
+    g_autoptr(DnfRepo) alpha_kept = getRepo("alpha");
+    CPPUNIT_ASSERT(alpha_modified == alpha_kept);
+}
+
+void RepoLoaderTest::testVarsChangeReparsesAll()
+{
+    auto loader = dnf_context_get_repo_loader(context);
+    g_autoptr(DnfRepo) alpha = getRepo("alpha");
+    g_autoptr(DnfRepo) beta = getRepo("beta");
+
+    dnf_context_set_release_ver(context, "27");
+    dnf_repo_loader_invalidate(loader);
+    g_autoptr(DnfRepo) alpha_new = getRepo("alpha");
+    g_autoptr(DnfRepo) beta_new = getRepo("beta");
+    CPPUNIT_ASSERT(alpha != alpha_new);
+    CPPUNIT_ASSERT(beta != beta_new);
+    CPPUNIT_ASSERT_EQUAL(std::string("Alpha 27"), std::string(dnf_repo_get_description(alpha_new)));
+}
+
+void RepoLoaderTest::testZchunkChangeReparsesAll()
+{
+    auto loader = dnf_context_get_repo_loader(context);
+    g_autoptr(DnfRepo) alpha = getRepo("alpha");
+    g_autoptr(DnfRepo) beta = getRepo("beta");
+
+    dnf_context_set_zchunk(context, !dnf_context_get_zchunk(context));
+    dnf_repo_loader_invalidate(loader);
+    g_autoptr(DnfRepo) alpha_new = getRepo("alpha");
+    g_autoptr(DnfRepo) beta_new = getRepo("beta");
+    CPPUNIT_ASSERT(alpha != alpha_new);
+    CPPUNIT_ASSERT(beta != beta_new);
+}
+
+void RepoLoaderTest::testModifiedRepoSetUpAgain()
+{
+    auto loader = dnf_context_get_repo_loader(context);
+    g_autoptr(DnfRepo) alpha = getRepo("alpha");
+    g_autoptr(DnfRepo) beta = getRepo("beta");
+    auto enabled = dnf_repo_get_enabled(alpha);
+    CPPUNIT_ASSERT(enabled & DNF_REPO_ENABLED_PACKAGES);
+
+    // the runtime change does not survive the refresh, unchanged repos are reused
+    dnf_repo_set_enabled(alpha, DNF_REPO_ENABLED_NONE);
+    dnf_repo_loader_invalidate(loader);
+    g_autoptr(DnfRepo) alpha_reset = getRepo("alpha");
+    g_autoptr(DnfRepo) beta_same = getRepo("beta");
+    CPPUNIT_ASSERT(alpha != alpha_reset);
+    CPPUNIT_ASSERT(beta == beta_same);
+    CPPUNIT_ASSERT_EQUAL(enabled, dnf_repo_get_enabled(alpha_reset));
+    CPPUNIT_ASSERT_EQUAL(std::string("Alpha 26"), std::string(dnf_repo_get_description(alpha_reset)));
+
+    // the repo set up again is reused by the next refresh
+    dnf_repo_loader_invalidate(loader);
+    g_autoptr(DnfRepo) alpha_same = getRepo("alpha");
+    CPPUNIT_ASSERT(alpha_reset == alpha_same);
+}
@@ -0,0 +1,39 @@
+#ifndef LIBDNF_REPOLOADERTEST_HPP
+#define LIBDNF_REPOLOADERTEST_HPP
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "libdnf/dnf-context.h"
+#include "libdnf/dnf-repo.h"
+
+#include <string>
+
+class RepoLoaderTest : public CppUnit::TestCase
+{
+    CPPUNIT_TEST_SUITE(RepoLoaderTest);
+        CPPUNIT_TEST(testUnchangedFilesNotReparsed);
+        CPPUNIT_TEST(testVarsChangeReparsesAll);
+        CPPUNIT_TEST(testZchunkChangeReparsesAll);
+        CPPUNIT_TEST(testModifiedRepoSetUpAgain);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+    void testUnchangedFilesNotReparsed();
+    void testVarsChangeReparsesAll();
+    void testZchunkChangeReparsesAll();
+    void testModifiedRepoSetUpAgain();
+
+private:
+    void writeRepoFile(const char * id, const char * name);
+    DnfRepo * getRepo(const char * id);
+
+    DnfContext * context;
+    char * tmpdir;
+    std::string reposDir;
+};
+
+#endif // LIBDNF_REPOLOADERTEST_HPP
@@ -133,6 +133,34 @@ void AdvisoryTest::testGetApplicablePackagesMultipleApplicableCollections()
     CPPUNIT_ASSERT(!g_strcmp0(pkgsvector[3].getNameString(), "not-present"));
 }
 
+void AdvisoryTest::testGetApplicablePackagesFollowsActiveModules()
+{
+    std::vector<libdnf::AdvisoryPkg> pkgsvector;
+    libdnf::ModulePackageContainer * modules = dnf_sack_get_module_container(sack);
+
+    // Cached applicability is dropped whenever the active modules are recomputed
+    advisory->getApplicablePackages(pkgsvector);
+    CPPUNIT_ASSERT(pkgsvector.size() == 4);
+
+    modules->reset("perl-DBI");
+    dnf_sack_filter_modules_v2(sack, modules, nullptr, tmpdir, nullptr, true, false, false);
+    pkgsvector.clear();
+    advisory->getApplicablePackages(pkgsvector);
+    CPPUNIT_ASSERT(pkgsvector.size() == 1);
+
+    CPPUNIT_ASSERT(modules->enable("perl-DBI", "master", false));
+    dnf_sack_filter_modules_v2(sack, modules, nullptr, tmpdir, nullptr, true, false, false);
+    pkgsvector.clear();
+    advisory->getApplicablePackages(pkgsvector);
+    CPPUNIT_ASSERT(pkgsvector.size() == 4);
+
+    // Until then the answers are reused, a reset alone does not change the active modules
+    modules->reset("perl-DBI");
+    pkgsvector.clear();
+    advisory->getApplicablePackages(pkgsvector);
+    CPPUNIT_ASSERT(pkgsvector.size() == 4);
+}
+
 void AdvisoryTest::testGetModules()
 {
     std::vector<libdnf::AdvisoryModule> modulesvector;
@@ -22,6 +22,7 @@ class AdvisoryTest : public CppUnit::TestCase
         CPPUNIT_TEST(testGetApplicablePackagesModulesSetupNoneEnabled);
         CPPUNIT_TEST(testGetApplicablePackagesOneApplicableCollection);
         CPPUNIT_TEST(testGetApplicablePackagesMultipleApplicableCollections);
+        CPPUNIT_TEST(testGetApplicablePackagesFollowsActiveModules);
         CPPUNIT_TEST(testGetModules);
         CPPUNIT_TEST(testGetReferences);
     CPPUNIT_TEST_SUITE_END();
@@ -40,6 +41,7 @@ public:
     void testGetApplicablePackagesModulesSetupNoneEnabled();
     void testGetApplicablePackagesOneApplicableCollection();
     void testGetApplicablePackagesMultipleApplicableCollections();
+    void testGetApplicablePackagesFollowsActiveModules();
     void testGetModules();
     void testGetReferences();
 
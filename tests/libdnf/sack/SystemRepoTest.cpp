@@ -0,0 +1,307 @@
+#include "SystemRepoTest.hpp"
+
+#include "libdnf/dnf-sack-private.hpp"
+#include "libdnf/dnf-types.h"
+#include "libdnf/hy-iutil-private.hpp"
+#include "libdnf/hy-package-private.hpp"
+#include "libdnf/repo/Repo-private.hpp"
+#include "libdnf/sack/query.hpp"
+
+#include <rpm/rpmlib.h>
+#include <rpm/rpmmacro.h>
+#include <solv/repo_solv.h>
+#include <solv/testcase.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SystemRepoTest);
+
+#define UNITTEST_DIR "/tmp/libdnfXXXXXX"
+
+static const char * AVAILABLE_REPO =
+    "=Ver: 2.0\n"
+    "=Pkg: tour 5 1 noarch\n"
+    "=Pkg: penny 4 1 noarch\n"
+    "=Req: /usr/bin/away\n";
+
+void SystemRepoTest::setUp()
+{
+    tmpdir = g_strdup(UNITTEST_DIR);
+    char *retptr = mkdtemp(tmpdir);
+    CPPUNIT_ASSERT(retptr);
+
+    // Fake rpmdb in the default location under the install root, only headers are written to it
+    rpmReadConfigFiles(NULL, NULL);
+    g_autofree char * rpmdb_path = rpmExpand("%{_dbpath}", NULL);
+    dbpath = std::string(tmpdir) + rpmdb_path;
+    CPPUNIT_ASSERT(g_mkdir_with_parents(dbpath.c_str(), 0755) == 0);
+    runRpm({"--initdb"});
+    runRpm({"-i", TESTDATADIR "/hawkey/yum/tour-4-6.noarch.rpm"});
+
+    sack = createSack(DNF_SACK_LOAD_FLAG_NONE);
+}
+
+void SystemRepoTest::tearDown()
+{
+    g_object_unref(sack);
+    dnf_remove_recursive_v2(tmpdir, NULL);
+    g_free(tmpdir);
+}
+
+DnfSack * SystemRepoTest::createSack(int flags)
+{
+    DnfSack * newSack = dnf_sack_new();
+    dnf_sack_set_cachedir(newSack, tmpdir);
+    dnf_sack_set_rootdir(newSack, tmpdir);
+    dnf_sack_set_arch(newSack, "x86_64", NULL);
+    dnf_sack_setup(newSack, 0, NULL);
+    CPPUNIT_ASSERT(dnf_sack_load_system_repo(newSack, NULL, flags, NULL));
+
+    Pool * pool = dnf_sack_get_pool(newSack);
+    HyRepo hrepo = hy_repo_create("available");
+    Repo * repo = repo_create(pool, "available");
+    libdnf::repoGetImpl(hrepo)->attachLibsolvRepo(repo);
+    hy_repo_free(hrepo);
+    FILE * fp = fmemopen(const_cast<char *>(AVAILABLE_REPO), strlen(AVAILABLE_REPO), "r");
+    CPPUNIT_ASSERT(fp);
+    testcase_add_testtags(repo, fp, 0);
+    fclose(fp);
+    return newSack;
+}
+
+void SystemRepoTest::runRpm(const std::vector<std::string> & args)
+{
+    // --dbpath instead of --root, the database is modified without chroot
+    std::vector<const char *> argv{"rpm", "--dbpath", dbpath.c_str()};
+    if (args[0] != "--initdb") {
+        for (auto arg : {"--justdb", "--nodeps", "--noscripts"}) {
+            argv.push_back(arg);
+        }
+    }
+    if (args[0] == "-i") {
+        argv.push_back("--ignorearch");
+        argv.push_back("--ignoreos");
+    }
+    for (auto & arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    argv.push_back(nullptr);
+
+    g_autoptr(GError) error = nullptr;
+    gint status = 0;
+    CPPUNIT_ASSERT(g_spawn_sync(NULL, const_cast<gchar **>(argv.data()), NULL, G_SPAWN_SEARCH_PATH,
+                                NULL, NULL, NULL, NULL, &status, &error));
+    CPPUNIT_ASSERT(g_spawn_check_exit_status(status, &error));
+}
+
+std::vector<std::string> SystemRepoTest::installedNames(libdnf::Query::ExcludeFlags flags)
+{
+    libdnf::Query query(sack, flags);
+    query.installed();
+    auto pset = query.runSet();
+    std::vector<std::string> names;
+    Id id = -1;
+    while ((id = pset->next(id)) != -1) {
+        g_autoptr(DnfPackage) pkg = dnf_package_new(sack, id);
+        names.push_back(dnf_package_get_name(pkg));
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void SystemRepoTest::testReloadSystemRepo()
+{
+    CPPUNIT_ASSERT(installedNames() == std::vector<std::string>{"tour"});
+
+    libdnf::Query available(sack);
+    available.available();
+    auto available_before = *available.runSet();
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), available_before.size());
+
+    // Package installed behind the sack's back
+    runRpm({"-i", TESTDATADIR "/hawkey/yum/mystery-devel-19.67-1.noarch.rpm"});
+    CPPUNIT_ASSERT(dnf_sack_reload_system_repo(sack, NULL));
+    CPPUNIT_ASSERT((installedNames() == std::vector<std::string>{"mystery-devel", "tour"}));
+
+    // Available packages were not reloaded, they keep their ids
+    libdnf::Query available_after(sack);
+    available_after.available();
+    auto available_after_set = *available_after.runSet();
+    CPPUNIT_ASSERT_EQUAL(available_before.size(), available_after_set.size());
+    Id id = -1;
+    while ((id = available_before.next(id)) != -1) {
+        CPPUNIT_ASSERT(available_after_set.has(id));
+    }
+
+    // Provides are ready for the new installed packages
+    libdnf::Query provides(sack);
+    provides.addFilter(HY_PKG_PROVIDES, HY_EQ, "mystery-devel");
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), provides.size());
+
+    // Package erased behind the sack's back
+    runRpm({"-e", "tour"});
+    CPPUNIT_ASSERT(dnf_sack_reload_system_repo(sack, NULL));
+    CPPUNIT_ASSERT(installedNames() == std::vector<std::string>{"mystery-devel"});
+
+    libdnf::Query upgrades(sack);
+    upgrades.addFilter(HY_PKG_NAME, HY_EQ, "tour");
+    upgrades.addFilter(HY_PKG_UPGRADES, HY_EQ, 1);
+    CPPUNIT_ASSERT(upgrades.empty());
+}
+
+static int freedSolvables(Pool * pool)
+{
+    int freed = 0;
+    for (Id id = 2; id < pool->nsolvables; ++id) {
+        if (!pool->solvables[id].repo)
+            ++freed;
+    }
+    return freed;
+}
+
+void SystemRepoTest::testRepeatedReload()
+{
+    Pool * pool = dnf_sack_get_pool(sack);
+
+    libdnf::Query tour(sack);
+    tour.installed();
+    tour.addFilter(HY_PKG_NAME, HY_EQ, "tour");
+    dnf_sack_add_excludes(sack, tour.runSet());
+    CPPUNIT_ASSERT(installedNames().empty());
+
+    // The system repo is not the last repo of the pool, the id of the previous tour stays unused
+    CPPUNIT_ASSERT(dnf_sack_reload_system_repo(sack, NULL));
+    CPPUNIT_ASSERT_EQUAL(1, freedSolvables(pool));
+    auto nsolvables = pool->nsolvables;
+
+    // The exclude follows the installed package to its new id
+    CPPUNIT_ASSERT(installedNames(libdnf::Query::ExcludeFlags::IGNORE_EXCLUDES) ==
+                   std::vector<std::string>{"tour"});
+    CPPUNIT_ASSERT(installedNames().empty());
+
+    // Another reload would leave as many unused ids as there are installed packages
+    runRpm({"-i", TESTDATADIR "/hawkey/yum/mystery-devel-19.67-1.noarch.rpm"});
+    g_autoptr(GError) error = nullptr;
+    CPPUNIT_ASSERT(!dnf_sack_reload_system_repo(sack, &error));
+    CPPUNIT_ASSERT(g_error_matches(error, DNF_ERROR, DNF_ERROR_NO_CAPABILITY));
+
+    // The sack is left untouched
+    CPPUNIT_ASSERT_EQUAL(nsolvables, pool->nsolvables);
+    CPPUNIT_ASSERT_EQUAL(1, freedSolvables(pool));
+    CPPUNIT_ASSERT(installedNames(libdnf::Query::ExcludeFlags::IGNORE_EXCLUDES) ==
+                   std::vector<std::string>{"tour"});
+    CPPUNIT_ASSERT(installedNames().empty());
+    libdnf::Query available(sack);
+    available.addFilter(HY_PKG_REPONAME, HY_EQ, "available");
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), available.size());
+
+    // A new sack, as set up by dnf_context_reload_system_repo() then, has no unused ids
+    g_object_unref(sack);
+    sack = createSack(DNF_SACK_LOAD_FLAG_NONE);
+    CPPUNIT_ASSERT_EQUAL(0, freedSolvables(dnf_sack_get_pool(sack)));
+    CPPUNIT_ASSERT((installedNames() == std::vector<std::string>{"mystery-devel", "tour"}));
+}
+
+static int systemRepoState(DnfSack * sack)
+{
+    auto hrepo = static_cast<HyRepo>(dnf_sack_get_pool(sack)->installed->appdata);
+    return libdnf::repoGetImpl(hrepo)->state_main;
+}
+
+static ino_t cacheInode(const char * path)
+{
+    struct stat st;
+    CPPUNIT_ASSERT(stat(path, &st) == 0);
+    return st.st_ino;
+}
+
+// file provides stored in the solv file by rewrite_repos()
+static bool cachedFileProvides(const char * path, const char * file)
+{
+    Pool * pool = pool_create();
+    Repo * repo = repo_create(pool, HY_SYSTEM_REPO_NAME);
+    FILE * fp = fopen(path, "r");
+    CPPUNIT_ASSERT(fp);
+    CPPUNIT_ASSERT(repo_add_solv(repo, fp, 0) == 0);
+    fclose(fp);
+    Queue fileprovides;
+    queue_init(&fileprovides);
+    repo_lookup_idarray(repo, SOLVID_META, REPOSITORY_ADDEDFILEPROVIDES, &fileprovides);
+    Id fileId = pool_str2id(pool, file, 0);
+    bool found = false;
+    for (int i = 0; i < fileprovides.count; ++i) {
+        if (fileprovides.elements[i] == fileId)
+            found = true;
+    }
+    queue_free(&fileprovides);
+    pool_free(pool);
+    return fileId && found;
+}
+
+static size_t installedProviders(DnfSack * sack, const char * provide)
+{
+    libdnf::Query query(sack);
+    query.installed();
+    query.addFilter(HY_PKG_PROVIDES, HY_EQ, provide);
+    return query.size();
+}
+
+void SystemRepoTest::testSystemRepoCache()
+{
+    g_autofree gchar * fn_cache = g_build_filename(tmpdir, HY_SYSTEM_REPO_NAME ".solv", NULL);
+    CPPUNIT_ASSERT(!g_file_test(fn_cache, G_FILE_TEST_EXISTS));
+
+    // The first load reads the rpmdb and writes the cache
+    DnfSack * cached = createSack(DNF_SACK_LOAD_FLAG_BUILD_CACHE);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(_HY_LOADED_FETCH), systemRepoState(cached));
+    CPPUNIT_ASSERT(g_file_test(fn_cache, G_FILE_TEST_EXISTS));
+
+    // The cache is rewritten with file provides required by the available repo
+    dnf_sack_make_provides_ready(cached);
+    CPPUNIT_ASSERT(cachedFileProvides(fn_cache, "/usr/bin/away"));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), installedProviders(cached, "/usr/bin/away"));
+    g_object_unref(cached);
+    auto inode = cacheInode(fn_cache);
+
+    // The second load uses the cache, it already contains the file provides
+    cached = createSack(DNF_SACK_LOAD_FLAG_BUILD_CACHE);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(_HY_LOADED_CACHE), systemRepoState(cached));
+    dnf_sack_make_provides_ready(cached);
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), installedProviders(cached, "/usr/bin/away"));
+    CPPUNIT_ASSERT_EQUAL(inode, cacheInode(fn_cache));
+    g_object_unref(cached);
+
+    // Touching the rpmdb files invalidates the cache
+    g_autoptr(GDir) dir = g_dir_open(dbpath.c_str(), 0, NULL);
+    CPPUNIT_ASSERT(dir);
+    while (auto name = g_dir_read_name(dir)) {
+        g_autofree gchar * path = g_build_filename(dbpath.c_str(), name, NULL);
+        if (g_file_test(path, G_FILE_TEST_IS_REGULAR)) {
+            const struct timespec times[2] = {{1000000000, 0}, {1000000000, 0}};
+            CPPUNIT_ASSERT(utimensat(AT_FDCWD, path, times, 0) == 0);
+        }
+    }
+    cached = createSack(DNF_SACK_LOAD_FLAG_BUILD_CACHE);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(_HY_LOADED_FETCH), systemRepoState(cached));
+    CPPUNIT_ASSERT(inode != cacheInode(fn_cache));
+    dnf_sack_make_provides_ready(cached);
+    CPPUNIT_ASSERT(cachedFileProvides(fn_cache, "/usr/bin/away"));
+    g_object_unref(cached);
+    inode = cacheInode(fn_cache);
+
+    // So does a change of the rpmdb, the new package is loaded and cached
+    runRpm({"-i", TESTDATADIR "/hawkey/yum/mystery-devel-19.67-1.noarch.rpm"});
+    cached = createSack(DNF_SACK_LOAD_FLAG_BUILD_CACHE);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(_HY_LOADED_FETCH), systemRepoState(cached));
+    CPPUNIT_ASSERT(inode != cacheInode(fn_cache));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), installedProviders(cached, "mystery-devel"));
+    g_object_unref(cached);
+
+    cached = createSack(DNF_SACK_LOAD_FLAG_BUILD_CACHE);
+    CPPUNIT_ASSERT_EQUAL(static_cast<int>(_HY_LOADED_CACHE), systemRepoState(cached));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), installedProviders(cached, "mystery-devel"));
+    g_object_unref(cached);
+}
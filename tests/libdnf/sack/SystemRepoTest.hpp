@@ -0,0 +1,40 @@
+#ifndef LIBDNF_SYSTEMREPOTEST_HPP
+#define LIBDNF_SYSTEMREPOTEST_HPP
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <libdnf/dnf-sack.h>
+#include <libdnf/sack/query.hpp>
+
+#include <string>
+#include <vector>
+
+class SystemRepoTest : public CppUnit::TestCase
+{
+    CPPUNIT_TEST_SUITE(SystemRepoTest);
+        CPPUNIT_TEST(testReloadSystemRepo);
+        CPPUNIT_TEST(testRepeatedReload);
+        CPPUNIT_TEST(testSystemRepoCache);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+    void testReloadSystemRepo();
+    void testRepeatedReload();
+    void testSystemRepoCache();
+
+private:
+    DnfSack * createSack(int flags);
+    void runRpm(const std::vector<std::string> & args);
+    std::vector<std::string> installedNames(
+        libdnf::Query::ExcludeFlags flags = libdnf::Query::ExcludeFlags::APPLY_EXCLUDES);
+
+    DnfSack *sack = nullptr;
+    char* tmpdir = nullptr;
+    std::string dbpath;
+};
+
+#endif //LIBDNF_SYSTEMREPOTEST_HPP
@@ -6,6 +6,7 @@
 #include "../backports.hpp"
 
 #include "libdnf/transaction/CompsEnvironmentItem.hpp"
+#include "libdnf/transaction/Swdb.hpp"
 #include "libdnf/transaction/Transformer.hpp"
 
 #include "CompsEnvironmentItemTest.hpp"
@@ -102,3 +103,43 @@ CompsEnvironmentItemTest::testGetTransactionItems()
         CPPUNIT_ASSERT_EQUAL(std::string("core"), group->getGroupId());
     }
 }
+
+static void
+finishEnvironmentTransaction(std::shared_ptr< SQLite3 > conn,
+                             const std::string &environmentId,
+                             const std::vector< std::string > &installedGroups,
+                             TransactionItemAction action)
+{
+    libdnf::swdb_private::Transaction trans(conn);
+    auto env = std::make_shared< CompsEnvironmentItem >(conn);
+    env->setEnvironmentId(environmentId);
+    env->setName(environmentId);
+    env->setTranslatedName(environmentId);
+    env->setPackageTypes(CompsPackageType::DEFAULT);
+    for (auto &groupId : installedGroups) {
+        env->addGroup(groupId, true, CompsPackageType::MANDATORY);
+    }
+    env->addGroup("not-installed", false, CompsPackageType::OPTIONAL);
+    env->save();
+    auto ti = trans.addItem(env, "", action, TransactionItemReason::USER);
+    ti->setState(TransactionItemState::DONE);
+    trans.begin();
+    trans.finish(TransactionState::DONE);
+}
+
+void
+CompsEnvironmentItemTest::testCompsGroupEnvironments()
+{
+    finishEnvironmentTransaction(conn, "minimal", {"core"}, TransactionItemAction::INSTALL);
+    finishEnvironmentTransaction(conn, "server", {"core", "base"}, TransactionItemAction::INSTALL);
+    finishEnvironmentTransaction(conn, "server", {"core", "base"}, TransactionItemAction::REMOVE);
+
+    Swdb swdb(conn);
+    CPPUNIT_ASSERT(swdb.getCompsGroupEnvironments("core") == std::vector< std::string >{"minimal"});
+    CPPUNIT_ASSERT(swdb.getCompsGroupEnvironments("base").empty());
+    CPPUNIT_ASSERT(swdb.getCompsGroupEnvironments("not-installed").empty());
+
+    finishEnvironmentTransaction(conn, "server", {"core", "base"}, TransactionItemAction::INSTALL);
+    CPPUNIT_ASSERT((swdb.getCompsGroupEnvironments("core") == std::vector< std::string >{"minimal", "server"}));
+    CPPUNIT_ASSERT(swdb.getCompsGroupEnvironments("base") == std::vector< std::string >{"server"});
+}
@@ -10,6 +10,7 @@ class CompsEnvironmentItemTest : public CppUnit::TestCase {
     CPPUNIT_TEST_SUITE(CompsEnvironmentItemTest);
     CPPUNIT_TEST(testCreate);
     CPPUNIT_TEST(testGetTransactionItems);
+    CPPUNIT_TEST(testCompsGroupEnvironments);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -18,6 +19,7 @@ public:
 
     void testCreate();
     void testGetTransactionItems();
+    void testCompsGroupEnvironments();
 
 private:
     std::shared_ptr< SQLite3 > conn;
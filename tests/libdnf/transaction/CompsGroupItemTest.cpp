@@ -6,6 +6,7 @@
 #include "../backports.hpp"
 
 #include "libdnf/transaction/CompsGroupItem.hpp"
+#include "libdnf/transaction/Swdb.hpp"
 #include "libdnf/transaction/Transformer.hpp"
 
 #include "CompsGroupItemTest.hpp"
@@ -102,3 +103,55 @@ CompsGroupItemTest::testGetTransactionItems()
         CPPUNIT_ASSERT_EQUAL(std::string("rpm"), pkg->getName());
     }
 }
+
+static void
+finishGroupTransaction(std::shared_ptr< SQLite3 > conn,
+                       const std::string &groupId,
+                       const std::vector< std::string > &installedPackages,
+                       TransactionItemAction action)
+{
+    libdnf::swdb_private::Transaction trans(conn);
+    auto grp = std::make_shared< CompsGroupItem >(conn);
+    grp->setGroupId(groupId);
+    grp->setName(groupId);
+    grp->setTranslatedName(groupId);
+    grp->setPackageTypes(CompsPackageType::DEFAULT);
+    for (auto &name : installedPackages) {
+        grp->addPackage(name, true, CompsPackageType::MANDATORY);
+    }
+    grp->addPackage("not-installed", false, CompsPackageType::OPTIONAL);
+    grp->save();
+    auto ti = trans.addItem(grp, "", action, TransactionItemReason::USER);
+    ti->setState(TransactionItemState::DONE);
+    trans.begin();
+    trans.finish(TransactionState::DONE);
+}
+
+void
+CompsGroupItemTest::testPackageCompsGroups()
+{
+    finishGroupTransaction(conn, "core", {"bash"}, TransactionItemAction::INSTALL);
+    finishGroupTransaction(conn, "base", {"bash", "vim"}, TransactionItemAction::INSTALL);
+    finishGroupTransaction(conn, "base", {"bash", "vim"}, TransactionItemAction::REMOVE);
+
+    Swdb swdb(conn);
+    CPPUNIT_ASSERT(swdb.getPackageCompsGroups("bash") == std::vector< std::string >{"core"});
+    CPPUNIT_ASSERT(swdb.getPackageCompsGroups("vim").empty());
+    CPPUNIT_ASSERT(swdb.getPackageCompsGroups("not-installed").empty());
+    CPPUNIT_ASSERT(swdb.getPackageCompsGroups("unknown").empty());
+
+    finishGroupTransaction(conn, "base", {"bash", "vim"}, TransactionItemAction::INSTALL);
+    CPPUNIT_ASSERT((swdb.getPackageCompsGroups("bash") == std::vector< std::string >{"base", "core"}));
+
+    // names above the per query limit, duplicates and names without groups
+    std::vector< std::string > names{"vim", "bash", "vim"};
+    for (int i = 0; i < 1200; ++i) {
+        names.push_back("unknown" + std::to_string(i));
+    }
+    names.push_back("bash");
+    auto groups = swdb.getPackagesCompsGroups(names);
+    CPPUNIT_ASSERT_EQUAL(static_cast< size_t >(2), groups.size());
+    CPPUNIT_ASSERT((groups["bash"] == std::vector< std::string >{"base", "core"}));
+    CPPUNIT_ASSERT(groups["vim"] == std::vector< std::string >{"base"});
+    CPPUNIT_ASSERT(swdb.getPackagesCompsGroups({}).empty());
+}
@@ -10,6 +10,7 @@ class CompsGroupItemTest : public CppUnit::TestCase {
     CPPUNIT_TEST_SUITE(CompsGroupItemTest);
     CPPUNIT_TEST(testCreate);
     CPPUNIT_TEST(testGetTransactionItems);
+    CPPUNIT_TEST(testPackageCompsGroups);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -18,6 +19,7 @@ public:
 
     void testCreate();
     void testGetTransactionItems();
+    void testPackageCompsGroups();
 
 private:
     std::shared_ptr< SQLite3 > conn;
@@ -5,8 +5,11 @@
 
 #include "libdnf/hy-subject.h"
 #include "libdnf/nevra.hpp"
+#include "libdnf/transaction/CompsEnvironmentItem.hpp"
+#include "libdnf/transaction/CompsGroupItem.hpp"
 #include "libdnf/transaction/RPMItem.hpp"
 #include "libdnf/transaction/MergedTransaction.hpp"
+#include "libdnf/transaction/Swdb.hpp"
 #include "libdnf/transaction/Transaction.hpp"
 #include "libdnf/transaction/Transformer.hpp"
 
@@ -900,6 +903,109 @@ MergedTransactionTest::test_multilib_identity()
     CPPUNIT_ASSERT_EQUAL(TransactionItemReason::USER, item3->getReason());
 }
 
+static void
+finishTrans(libdnf::swdb_private::TransactionPtr trans)
+{
+    for (auto ti : trans->getItems()) {
+        ti->setState(TransactionItemState::DONE);
+    }
+    trans->begin();
+    trans->finish(TransactionState::DONE);
+}
+
+void
+MergedTransactionTest::testGetMergedTransaction()
+{
+    auto core = std::make_shared< CompsGroupItem >(conn);
+    core->setGroupId("core");
+    core->setName("Core");
+    core->setTranslatedName("Core");
+    core->setPackageTypes(CompsPackageType::DEFAULT);
+    core->addPackage("tour", true, CompsPackageType::MANDATORY);
+    core->save();
+
+    auto minimal = std::make_shared< CompsEnvironmentItem >(conn);
+    minimal->setEnvironmentId("minimal");
+    minimal->setName("Minimal Environment");
+    minimal->setTranslatedName("Minimal Environment");
+    minimal->setPackageTypes(CompsPackageType::DEFAULT);
+    minimal->addGroup("core", true, CompsPackageType::MANDATORY);
+    minimal->save();
+
+    auto trans1 = std::make_shared< libdnf::swdb_private::Transaction >(conn);
+    trans1->addItem(nevraToRPMItem(conn, "tour-0:4.8-1.noarch"), "repo1",
+                    TransactionItemAction::INSTALL, TransactionItemReason::GROUP);
+    trans1->addItem(nevraToRPMItem(conn, "lotus-0:3-16.x86_64"), "repo1",
+                    TransactionItemAction::INSTALL, TransactionItemReason::USER);
+    trans1->addItem(core, "", TransactionItemAction::INSTALL, TransactionItemReason::USER);
+    finishTrans(trans1);
+
+    auto trans2 = std::make_shared< libdnf::swdb_private::Transaction >(conn);
+    trans2->addItem(nevraToRPMItem(conn, "tour-0:4.6-1.noarch"), "repo2",
+                    TransactionItemAction::DOWNGRADE, TransactionItemReason::GROUP);
+    trans2->addItem(nevraToRPMItem(conn, "tour-0:4.8-1.noarch"), "repo1",
+                    TransactionItemAction::DOWNGRADED, TransactionItemReason::GROUP);
+    trans2->addItem(minimal, "", TransactionItemAction::INSTALL, TransactionItemReason::USER);
+    finishTrans(trans2);
+
+    auto trans3 = std::make_shared< libdnf::swdb_private::Transaction >(conn);
+    trans3->addItem(nevraToRPMItem(conn, "lotus-0:3-16.x86_64"), "repo1",
+                    TransactionItemAction::REMOVE, TransactionItemReason::USER);
+    trans3->addItem(nevraToRPMItem(conn, "pepper-0:20-0.x86_64"), "repo1",
+                    TransactionItemAction::INSTALL, TransactionItemReason::USER);
+    finishTrans(trans3);
+
+    auto trans4 = std::make_shared< libdnf::swdb_private::Transaction >(conn);
+    trans4->addItem(nevraToRPMItem(conn, "tour-0:4.6-1.noarch"), "repo2",
+                    TransactionItemAction::UPGRADED, TransactionItemReason::GROUP);
+    trans4->addItem(nevraToRPMItem(conn, "tour-0:4.9-1.noarch"), "repo1",
+                    TransactionItemAction::UPGRADE, TransactionItemReason::GROUP);
+    trans4->addItem(core, "", TransactionItemAction::UPGRADE, TransactionItemReason::USER);
+    finishTrans(trans4);
+
+    Swdb swdb(conn);
+    std::vector< int64_t > ids = {trans1->getId(), trans2->getId(), trans3->getId(), trans4->getId()};
+
+    // every range of transactions gives the same items as merging them one by one
+    for (size_t from = 0; from < ids.size(); ++from) {
+        for (size_t to = from; to < ids.size(); ++to) {
+            MergedTransaction incremental(std::make_shared< Transaction >(conn, ids[from]));
+            for (size_t i = from + 1; i <= to; ++i) {
+                incremental.merge(std::make_shared< Transaction >(conn, ids[i]));
+            }
+            auto expected = incremental.getItems();
+
+            auto merged = swdb.getMergedTransaction(ids[from], ids[to]);
+            CPPUNIT_ASSERT(merged);
+            CPPUNIT_ASSERT(merged->listIds() == incremental.listIds());
+            auto items = merged->getItems();
+            CPPUNIT_ASSERT_EQUAL(expected.size(), items.size());
+            for (size_t i = 0; i < items.size(); ++i) {
+                CPPUNIT_ASSERT_EQUAL(expected[i]->getItem()->toStr(), items[i]->getItem()->toStr());
+                CPPUNIT_ASSERT_EQUAL(expected[i]->getRepoid(), items[i]->getRepoid());
+                CPPUNIT_ASSERT_EQUAL(expected[i]->getAction(), items[i]->getAction());
+                CPPUNIT_ASSERT_EQUAL(expected[i]->getReason(), items[i]->getReason());
+            }
+        }
+    }
+
+    // the whole history contains all item types
+    auto items = swdb.getMergedTransaction(ids.front(), ids.back())->getItems();
+    std::set< ItemType > types;
+    for (auto item : items) {
+        types.insert(item->getItem()->getItemType());
+    }
+    CPPUNIT_ASSERT_EQUAL(static_cast< size_t >(3), types.size());
+
+    // merging another transaction drops the loaded items
+    auto merged = swdb.getMergedTransaction(ids[0], ids[1]);
+    merged->merge(std::make_shared< Transaction >(conn, ids[2]));
+    CPPUNIT_ASSERT_EQUAL(swdb.getMergedTransaction(ids[0], ids[2])->getItems().size(),
+                         merged->getItems().size());
+
+    CPPUNIT_ASSERT(swdb.getMergedTransaction(ids.back() + 1, ids.back() + 10) == nullptr);
+}
+
 /*
     def test_add_obsoleted_removed(self):
         """Test add with an obsoleted NEVRA which was removed before."""
@@ -31,6 +31,8 @@ class MergedTransactionTest : public CppUnit::TestCase {
 
     CPPUNIT_TEST(test_multilib_identity);
 
+    CPPUNIT_TEST(testGetMergedTransaction);
+
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -61,6 +63,8 @@ public:
     void test_downgrade_upgrade_remove();
 
     void test_multilib_identity();
+
+    void testGetMergedTransaction();
 private:
     std::shared_ptr< SQLite3 > conn;
 };
@@ -119,3 +119,55 @@ RpmItemTest::testGetTransactionItems()
     //CPPUNIT_ASSERT(createMs.count() == 0);
     //CPPUNIT_ASSERT(readMs.count() == 0);
 }
+
+void
+RpmItemTest::testSearchTransactions()
+{
+    // synthetic history: 50k packages spread over 10 transactions, the last one not finished
+    conn->exec(R"**(
+        INSERT INTO trans (id, dt_begin, releasever, user_id, state)
+            WITH RECURSIVE seq(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM seq WHERE i < 10)
+            SELECT i, i, '30', 0, CASE WHEN i = 10 THEN 2 ELSE 1 END FROM seq;
+        WITH RECURSIVE seq(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM seq WHERE i < 50000)
+            INSERT INTO item SELECT i, 1 FROM seq;
+        INSERT INTO rpm
+            SELECT id, 'pkg' || id, id % 3, '1.' || (id % 100), (id % 7) || '.fc30', 'x86_64' FROM item;
+        INSERT INTO trans_item (trans_id, item_id, action, reason, state)
+            SELECT id % 10 + 1, id, 1, 1, 1 FROM item;
+    )**");
+
+    auto search = [this](const std::vector< std::string > &patterns) {
+        return RPMItem::searchTransactions(conn, patterns);
+    };
+    const std::vector< int64_t > allDone{1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    // exact name
+    CPPUNIT_ASSERT((search({"pkg12345"}) == std::vector< int64_t >{6}));
+    // only finished transactions
+    CPPUNIT_ASSERT(search({"pkg9"}).empty());
+    // exact version
+    CPPUNIT_ASSERT((search({"1.42"}) == std::vector< int64_t >{3}));
+    // prefix: pkg4999 is in the unfinished transaction, pkg49990 - pkg49999 in all the others
+    CPPUNIT_ASSERT(search({"pkg4999*"}) == allDone);
+    // glob starting with a wildcard
+    CPPUNIT_ASSERT((search({"*g7"}) == std::vector< int64_t >{8}));
+    // globs match the epoch like the exact lookup does, no other column is a single digit
+    CPPUNIT_ASSERT(search({"[2]"}) == allDone);
+    CPPUNIT_ASSERT(search({"[3-9]"}).empty());
+    // several patterns, results are merged
+    CPPUNIT_ASSERT((search({"pkg12345", "pkg7", "pkg12345"}) == std::vector< int64_t >{6, 8}));
+    CPPUNIT_ASSERT(search({"nonexistent", "nonexistent*"}).empty());
+
+    // exact and prefix lookups go through the indexes created by the schema migration
+    for (auto column : {"name", "version", "release", "arch"}) {
+        for (auto op : {"=", "GLOB"}) {
+            SQLite3::Query plan(*conn, std::string("EXPLAIN QUERY PLAN SELECT item_id FROM rpm WHERE ") +
+                                       column + " " + op + " 'abc*'");
+            bool usesIndex = false;
+            while (plan.step() == SQLite3::Statement::StepResult::ROW) {
+                usesIndex |= plan.get< std::string >("detail").find("SEARCH") != std::string::npos;
+            }
+            CPPUNIT_ASSERT(usesIndex);
+        }
+    }
+}
@@ -153,3 +153,33 @@ TransactionTest::testComparison()
     second.setRpmdbVersionBegin("0");
     CPPUNIT_ASSERT(first == second);
 }
+
+void
+TransactionTest::testInsertManyItems()
+{
+    // every item is saved through the same few statements from the connection's cache
+    constexpr int count = 10000;
+    libdnf::swdb_private::Transaction trans(conn);
+    trans.setDtBegin(1);
+    trans.setRpmdbVersionBegin("begin - TransactionTest::testInsertManyItems");
+    trans.setReleasever("26");
+    trans.setUserId(1000);
+    trans.setCmdline("dnf install many");
+    for (int i = 0; i < count; ++i) {
+        auto rpm = nevraToRPMItem(conn, "pkg" + std::to_string(i) + "-1.0-1.fc29.x86_64");
+        auto ti = trans.addItem(rpm, "base", TransactionItemAction::INSTALL, TransactionItemReason::USER);
+        ti->setState(TransactionItemState::DONE);
+    }
+    trans.begin();
+    trans.setDtEnd(2);
+    trans.setRpmdbVersionEnd("end - TransactionTest::testInsertManyItems");
+    trans.finish(TransactionState::DONE);
+
+    libdnf::Transaction trans2(conn, trans.getId());
+    auto items = trans2.getItems();
+    CPPUNIT_ASSERT_EQUAL(static_cast< size_t >(count), items.size());
+    for (auto &item : items) {
+        CPPUNIT_ASSERT(item->getState() == TransactionItemState::DONE);
+        CPPUNIT_ASSERT_EQUAL(std::string("base"), item->getRepoid());
+    }
+}
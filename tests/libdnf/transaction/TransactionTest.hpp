@@ -12,6 +12,7 @@ class TransactionTest : public CppUnit::TestCase {
     CPPUNIT_TEST(testInsertWithSpecifiedId);
     CPPUNIT_TEST(testUpdate);
     CPPUNIT_TEST(testComparison);
+    CPPUNIT_TEST(testInsertManyItems);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -22,6 +23,7 @@ public:
     void testInsertWithSpecifiedId();
     void testUpdate();
     void testComparison();
+    void testInsertManyItems();
 
 private:
     std::shared_ptr< SQLite3 > conn;
@@ -27,6 +27,10 @@ static const char *create_history_sql =
 #include "sql/create_test_history_db.sql"
     ;
 
+static const char *generate_history_sql =
+#include "sql/generate_test_history_db.sql"
+    ;
+
 static const char *groups_json =
 #include "assets/groups.json"
     ;
@@ -212,3 +216,63 @@ TransformerTest::testTransformTrans()
 
     swdb->backup("sql.db");
 }
+
+void
+TransformerTest::testTransformLargeHistory()
+{
+    // transactions 3 to 2002 are generated on top of the two hand written ones
+    history->exec(generate_history_sql);
+    transformer.transformTrans(swdb, history);
+
+    SQLite3::Query countQuery(*swdb, "SELECT COUNT(*) AS count FROM trans");
+    CPPUNIT_ASSERT(countQuery.step() == SQLite3::Statement::StepResult::ROW);
+    CPPUNIT_ASSERT_EQUAL(2002, countQuery.get< int >("count"));
+
+    // the hand written transactions are migrated as without the generated ones
+    libdnf::Transaction first(swdb, 1);
+    CPPUNIT_ASSERT(first.getCmdline() == "upgrade -y");
+    CPPUNIT_ASSERT(first.getReleasever() == "26");
+    CPPUNIT_ASSERT(first.getItems().size() == 2);
+
+    for (int64_t id = 3; id <= 2002; ++id) {
+        libdnf::Transaction trans(swdb, id);
+        auto name = "pkg" + std::to_string(id);
+        CPPUNIT_ASSERT_EQUAL(id, trans.getId());
+        CPPUNIT_ASSERT_EQUAL(1513300000 + 10 * id, trans.getDtBegin());
+        CPPUNIT_ASSERT_EQUAL(1513300005 + 10 * id, trans.getDtEnd());
+        CPPUNIT_ASSERT_EQUAL("begin " + std::to_string(id), trans.getRpmdbVersionBegin());
+        CPPUNIT_ASSERT_EQUAL("end " + std::to_string(id), trans.getRpmdbVersionEnd());
+        CPPUNIT_ASSERT_EQUAL("upgrade " + name, trans.getCmdline());
+        CPPUNIT_ASSERT(trans.getState() ==
+                       (id % 100 == 0 ? TransactionState::ERROR : TransactionState::DONE));
+
+        auto output = trans.getConsoleOutput();
+        CPPUNIT_ASSERT_EQUAL(static_cast< size_t >(1), output.size());
+        CPPUNIT_ASSERT_EQUAL("output " + std::to_string(id), output[0].second);
+
+        auto softWith = trans.getSoftwarePerformedWith();
+        CPPUNIT_ASSERT_EQUAL(static_cast< size_t >(1), softWith.size());
+        CPPUNIT_ASSERT((*softWith.begin())->getName() == "kernel");
+
+        auto items = trans.getItems();
+        CPPUNIT_ASSERT_EQUAL(static_cast< size_t >(3), items.size());
+        for (auto item : items) {
+            auto rpm = std::dynamic_pointer_cast< RPMItem >(item->getItem());
+            CPPUNIT_ASSERT(item->getRepoid() == "fedora");
+            CPPUNIT_ASSERT(item->getState() == TransactionItemState::DONE);
+            if (rpm->getName() == name && rpm->getVersion() == "2.0") {
+                CPPUNIT_ASSERT(item->getAction() == TransactionItemAction::UPGRADE);
+                CPPUNIT_ASSERT(item->getReason() == TransactionItemReason::USER);
+            } else if (rpm->getName() == name) {
+                CPPUNIT_ASSERT(rpm->getVersion() == "1.0");
+                CPPUNIT_ASSERT(item->getAction() == TransactionItemAction::UPGRADED);
+                CPPUNIT_ASSERT(item->getReason() == TransactionItemReason::USER);
+            } else {
+                CPPUNIT_ASSERT(rpm->getName() == "dep" + std::to_string(id));
+                CPPUNIT_ASSERT(rpm->getEpoch() == 1);
+                CPPUNIT_ASSERT(item->getAction() == TransactionItemAction::INSTALL);
+                CPPUNIT_ASSERT(item->getReason() == TransactionItemReason::DEPENDENCY);
+            }
+        }
+    }
+}
@@ -18,6 +18,7 @@ class TransformerTest : public CppUnit::TestCase {
     CPPUNIT_TEST_SUITE(TransformerTest);
     CPPUNIT_TEST(testGroupTransformation);
     CPPUNIT_TEST(testTransformTrans);
+    CPPUNIT_TEST(testTransformLargeHistory);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -25,6 +26,7 @@ public:
     void tearDown() override;
 
     void testTransformTrans();
+    void testTransformLargeHistory();
     void testGroupTransformation();
 
 protected:
@@ -0,0 +1,38 @@
+R"**(
+    /* Append transactions 3 to 2002 to the test history database */
+
+    CREATE TEMP TABLE gen AS
+        WITH RECURSIVE seq(tid) AS (SELECT 3 UNION ALL SELECT tid + 1 FROM seq WHERE tid < 2002)
+        SELECT tid FROM seq;
+
+    INSERT INTO pkgtups
+        SELECT 10 * tid + 1, 'pkg' || tid, 'x86_64', 0, '1.0', '1.fc26', NULL FROM gen
+        UNION ALL
+        SELECT 10 * tid + 2, 'pkg' || tid, 'x86_64', 0, '2.0', '1.fc26', NULL FROM gen
+        UNION ALL
+        SELECT 10 * tid + 3, 'dep' || tid, 'noarch', 1, '0.1', '1.fc26', NULL FROM gen;
+
+    INSERT INTO pkg_yumdb
+        SELECT pkgtupid, 'reason', CASE WHEN pkgtupid % 10 = 3 THEN 'dep' ELSE 'user' END
+        FROM pkgtups WHERE pkgtupid > 3
+        UNION ALL
+        SELECT pkgtupid, 'from_repo', 'fedora' FROM pkgtups WHERE pkgtupid > 3;
+
+    INSERT INTO trans_beg SELECT tid, 1513300000 + 10 * tid, 'begin ' || tid, 1000 FROM gen;
+    INSERT INTO trans_end SELECT tid, 1513300005 + 10 * tid, 'end ' || tid, tid % 100 = 0 FROM gen;
+    INSERT INTO trans_cmdline SELECT tid, 'upgrade pkg' || tid FROM gen;
+    INSERT INTO trans_script_stdout (tid, line) SELECT tid, 'output ' || tid FROM gen;
+
+    /* the order is important - Update, Updated */
+    INSERT INTO trans_data_pkgs
+        SELECT tid, pkgtupid, done, state FROM (
+            SELECT tid, 10 * tid + 2 AS pkgtupid, 'TRUE' AS done, 'Update' AS state, 1 AS pos FROM gen
+            UNION ALL
+            SELECT tid, 10 * tid + 1, 'TRUE', 'Updated', 2 FROM gen
+            UNION ALL
+            SELECT tid, 10 * tid + 3, 'TRUE', 'Dep-Install', 3 FROM gen
+        )
+        ORDER BY tid, pos;
+
+    INSERT INTO trans_with_pkgs SELECT tid, 2 FROM gen;
+)**"